@@ -0,0 +1,37 @@
+#ifndef BENCH_BENCH_H_
+#define BENCH_BENCH_H_
+
+#include <libk/Types.h>
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * Helpers shared by the benchmark drivers in this directory, see `make bench`.
+ * Every driver generates its own input from a fixed seed, so runs are comparable without any data files, and reports
+ * the best of a few runs to keep scheduler noise out of the numbers.
+ */
+
+#define BENCH_RUNS 5
+
+static inline f64 benchSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+}
+
+// xorshift64, `state` must not be 0
+static inline u64 benchRandom(u64 *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static inline void benchReport(cstr name, f64 seconds, usize count, cstr unit) {
+    printf("  %-32s %10.2f ns/%s\n", name, seconds * 1e9 / (f64)count, unit);
+}
+
+// Results are added here so the optimizer can't drop the work that produced them
+static volatile u64 benchSink;
+
+#endif // BENCH_BENCH_H_
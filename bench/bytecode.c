@@ -0,0 +1,121 @@
+#include "Bench.h"
+#include "Bytecode.h"
+#include "Interner.h"
+
+/**
+ * Evaluating one expression many times: the evalExpr tree walk against compileExpr once followed by runBytecode, on a
+ * deep left leaning chain and on a wide balanced tree. evalExpr can't read identifiers, so both get trees of integer
+ * literals. The bytecode also runs the same shapes with identifier leaves bound through an environment, the way
+ * tooling evaluates an expression under different bindings.
+ */
+
+#define BYTECODE_DEEP_NODES 100000
+#define BYTECODE_WIDE_DEPTH 16
+#define BYTECODE_NODES_PER_RUN 10000000
+#define BYTECODE_VARIABLES 8
+
+// None of these overflow on leaves below 100, and none can divide by zero
+static const TokenType ops[] = {TOK_PLUS, TOK_MINUS, TOK_CARET, TOK_AMPERSAND, TOK_PIPE, TOK_LESS, TOK_EQUALS_EQUALS};
+
+static Symbol variables[BYTECODE_VARIABLES];
+
+static Expr *makeLeaf(Arena *arena, u64 *seed, Bool useVariables) {
+    u64 pick = benchRandom(seed);
+    if (useVariables && pick % 2 == 0) {
+        Token name = {.type = TOK_IDENTIFIER, .as.identifier.symbol = variables[pick / 2 % BYTECODE_VARIABLES]};
+        return makePrimaryExpr(arena, name);
+    }
+    Token literal = {.type = TOK_INTEGER_LITERAL, .as.integerLiteral = pick % 100};
+    return makePrimaryExpr(arena, literal);
+}
+
+static TokenType pickOp(u64 *seed) { return ops[benchRandom(seed) % (sizeof(ops) / sizeof(ops[0]))]; }
+
+// `nodes` operators applied one after the other, like a + b - c ^ d ...
+static Expr *makeDeep(Arena *arena, u64 *seed, usize nodes, Bool useVariables) {
+    Expr *root = makeLeaf(arena, seed, useVariables);
+    for (usize i = 0; i < nodes; i++) {
+        Expr *leaf = makeLeaf(arena, seed, useVariables);
+        root = makeBinaryExpr(arena, pickOp(seed), root, leaf);
+    }
+    return root;
+}
+
+// Complete tree of operators `depth` levels high, every eighth of them a ?: choosing between its two subtrees
+static Expr *makeWide(Arena *arena, u64 *seed, usize depth, Bool useVariables) {
+    if (depth == 0) return makeLeaf(arena, seed, useVariables);
+    Expr *lhs = makeWide(arena, seed, depth - 1, useVariables);
+    Expr *rhs = makeWide(arena, seed, depth - 1, useVariables);
+    if (benchRandom(seed) % 8 == 0) return makeConditionalExpr(arena, makeLeaf(arena, seed, useVariables), lhs, rhs);
+    return makeBinaryExpr(arena, pickOp(seed), lhs, rhs);
+}
+
+static f64 timeEvalExpr(Expr *root, usize evals) {
+    f64 best = 1e30;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        u64 sum = 0;
+        f64 start = benchSeconds();
+        for (usize i = 0; i < evals; i++) sum += (u64)evalExpr(root);
+        f64 seconds = benchSeconds() - start;
+        benchSink += sum;
+        if (seconds < best) best = seconds;
+    }
+    return best;
+}
+
+static f64 timeBytecode(const Bytecode *code, int *env, usize evals) {
+    f64 best = 1e30;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        u64 sum = 0;
+        f64 start = benchSeconds();
+        for (usize i = 0; i < evals; i++) {
+            // A new binding for every evaluation
+            if (code->variables.len > 0) env[i % code->variables.len] = (int)(i % 100);
+            sum += (u64)runBytecode(code, env);
+        }
+        f64 seconds = benchSeconds() - start;
+        benchSink += sum;
+        if (seconds < best) best = seconds;
+    }
+    return best;
+}
+
+static Bool benchShape(cstr shape, Expr *literals, Expr *identifiers, usize nodes) {
+    Bytecode code, bound;
+    if (!compileExpr(&code, literals) || !compileExpr(&bound, identifiers)) {
+        fprintf(stderr, "%s: the expression doesn't compile\n", shape);
+        return FALSE;
+    }
+    if (runBytecode(&code, NULL) != evalExpr(literals)) {
+        fprintf(stderr, "%s: runBytecode disagrees with evalExpr\n", shape);
+        return FALSE;
+    }
+
+    int env[BYTECODE_VARIABLES] = {0};
+    usize evals = BYTECODE_NODES_PER_RUN / nodes;
+    printf("%s: %zu operators, %zu instructions, %zu registers, %zu evaluations\n", shape, nodes, code.code.len,
+           code.registerCount, evals);
+    benchReport("evalExpr", timeEvalExpr(literals, evals), evals * nodes, "node");
+    benchReport("runBytecode", timeBytecode(&code, env, evals), evals * nodes, "node");
+    benchReport("runBytecode, identifiers", timeBytecode(&bound, env, evals), evals * nodes, "node");
+
+    freeBytecode(&code);
+    freeBytecode(&bound);
+    return TRUE;
+}
+
+int main(void) {
+    static u8 names[] = "abcdefgh";
+    for (usize i = 0; i < BYTECODE_VARIABLES; i++) variables[i] = intern((String){.data = names + i, .len = 1});
+
+    Arena arena = {0};
+    u64 seed = 22;
+    usize wideNodes = ((usize)1 << BYTECODE_WIDE_DEPTH) - 1;
+    printf("bytecode: best of %d runs\n", BENCH_RUNS);
+    Bool ok = benchShape("deep", makeDeep(&arena, &seed, BYTECODE_DEEP_NODES, FALSE),
+                         makeDeep(&arena, &seed, BYTECODE_DEEP_NODES, TRUE), BYTECODE_DEEP_NODES) &&
+              benchShape("wide", makeWide(&arena, &seed, BYTECODE_WIDE_DEPTH, FALSE),
+                         makeWide(&arena, &seed, BYTECODE_WIDE_DEPTH, TRUE), wideNodes);
+    freeArena(&arena);
+    return ok ? 0 : 1;
+}
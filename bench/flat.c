@@ -0,0 +1,168 @@
+#include "Bench.h"
+#include "FlatAst.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+#include <fcntl.h>
+#include <libk/StringBuilder.h>
+#include <unistd.h>
+
+/**
+ * Pointer trees against flat trees on the same input: the initializers of generated declarations, parsed once into
+ * Exprs and flattened into one FlatAst. Both are evaluated with evalExpr and evalFlatExpr and printed with printExpr
+ * and printFlatExpr, which write to stdout, so stdout is pointed at /dev/null while they are timed. The expressions
+ * only hold integer literals and operators that can't trap, evalExpr doesn't read identifiers.
+ */
+
+#define FLAT_DECLARATIONS 1000
+#define FLAT_MAX_DEPTH 10
+// Printing costs far more per node than evaluating, it only gets the first trees
+#define FLAT_PRINTED_TREES 100
+
+static cstr binaryOps[] = {"+", "-", "^", "&", "|", "<", "==", "!="};
+static cstr unaryOps[] = {"-", "!", "~"};
+
+static void emit(StringBuilder *out, cstr text) {
+    while (*text != '\0') joinByte(out, (u8)*text++);
+}
+
+static void emitExpr(StringBuilder *out, u64 *seed, usize depth) {
+    u64 pick = benchRandom(seed) % 16;
+    if (depth == 0 || pick < 2) {
+        char digits[8];
+        snprintf(digits, sizeof(digits), "%u", (unsigned)(benchRandom(seed) % 100));
+        emit(out, digits);
+    } else if (pick < 4) {
+        emit(out, unaryOps[benchRandom(seed) % (sizeof(unaryOps) / sizeof(unaryOps[0]))]);
+        emitExpr(out, seed, depth - 1);
+    } else if (pick < 5) {
+        emit(out, "(");
+        emitExpr(out, seed, depth - 1);
+        emit(out, ")");
+    } else if (pick < 6) {
+        emitExpr(out, seed, depth - 1);
+        emit(out, " ? ");
+        emitExpr(out, seed, depth - 1);
+        emit(out, " : ");
+        emitExpr(out, seed, depth - 1);
+    } else {
+        emitExpr(out, seed, depth - 1);
+        emit(out, " ");
+        emit(out, binaryOps[benchRandom(seed) % (sizeof(binaryOps) / sizeof(binaryOps[0]))]);
+        emit(out, " ");
+        emitExpr(out, seed, depth - 1);
+    }
+}
+
+typedef struct {
+    const SourceFile *source;
+    Expr **exprs;
+    FlatAst *flat;
+    FlatRef *refs;
+    usize count;
+} Trees;
+
+static void evalTrees(const Trees *trees) {
+    u64 sum = 0;
+    for (usize i = 0; i < trees->count; i++) sum += (u64)evalExpr(trees->exprs[i]);
+    benchSink += sum;
+}
+
+static void evalFlatTrees(const Trees *trees) {
+    u64 sum = 0;
+    for (usize i = 0; i < trees->count; i++) sum += (u64)evalFlatExpr(trees->flat, trees->refs[i]);
+    benchSink += sum;
+}
+
+static void printTrees(const Trees *trees) {
+    for (usize i = 0; i < trees->count; i++) printExpr(trees->source, trees->exprs[i]);
+}
+
+static void printFlatTrees(const Trees *trees) {
+    for (usize i = 0; i < trees->count; i++) printFlatExpr(trees->source, trees->flat, trees->refs[i]);
+}
+
+static f64 timeTrees(void (*pass)(const Trees *), const Trees *trees, Bool silence) {
+    int saved = -1;
+    if (silence) {
+        fflush(stdout);
+        saved = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        if (saved < 0 || null < 0) exit(1);
+        dup2(null, STDOUT_FILENO);
+        close(null);
+    }
+
+    f64 best = 1e30;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        f64 start = benchSeconds();
+        pass(trees);
+        if (silence) fflush(stdout);
+        f64 seconds = benchSeconds() - start;
+        if (seconds < best) best = seconds;
+    }
+
+    if (silence) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+    return best;
+}
+
+int main(void) {
+    StringBuilder text = {0};
+    u64 seed = 15;
+    for (usize i = 0; i < FLAT_DECLARATIONS; i++) {
+        emit(&text, "i32 v = ");
+        emitExpr(&text, &seed, FLAT_MAX_DEPTH);
+        emit(&text, ";\n");
+    }
+    SourceFile source = {.contents = moveToString(&text)};
+    buildLineIndex(&source);
+
+    TokensList tokens = {0};
+    Arena arena = {0};
+    Diagnostics diagnostics = {0};
+    if (!scanSource(&tokens, &source)) {
+        fprintf(stderr, "Generated source doesn't lex\n");
+        return 1;
+    }
+    StmtList list = parse(&arena, &source, tokens, &diagnostics);
+    if (list.len != FLAT_DECLARATIONS || diagnostics.len != 0) {
+        fprintf(stderr, "Generated source doesn't parse\n");
+        return 1;
+    }
+
+    FlatAst flat = {0};
+    Trees trees = {.source = &source, .flat = &flat, .count = list.len};
+    trees.exprs = malloc(list.len * sizeof(Expr *));
+    trees.refs = malloc(list.len * sizeof(FlatRef));
+    if (trees.exprs == NULL || trees.refs == NULL) exit(1);
+    for (usize i = 0; i < list.len; i++) {
+        trees.exprs[i] = list.arr[i]->as.declaration.initializer;
+        trees.refs[i] = flattenExpr(&flat, trees.exprs[i]);
+        if (evalExpr(trees.exprs[i]) != evalFlatExpr(&flat, trees.refs[i])) {
+            fprintf(stderr, "evalFlatExpr disagrees with evalExpr on declaration %zu\n", i);
+            return 1;
+        }
+    }
+
+    // Children come before their parents, the first trees end at the root of the last of them
+    Trees printed = trees;
+    printed.count = FLAT_PRINTED_TREES;
+    usize nodes = flat.nodes.len, printedNodes = trees.refs[FLAT_PRINTED_TREES - 1] + 1;
+    printf("flat: %zu trees, %zu nodes, best of %d runs\n", trees.count, nodes, BENCH_RUNS);
+    benchReport("evalExpr", timeTrees(evalTrees, &trees, FALSE), nodes, "node");
+    benchReport("evalFlatExpr", timeTrees(evalFlatTrees, &trees, FALSE), nodes, "node");
+    benchReport("printExpr", timeTrees(printTrees, &printed, TRUE), printedNodes, "node");
+    benchReport("printFlatExpr", timeTrees(printFlatTrees, &printed, TRUE), printedNodes, "node");
+
+    free(trees.exprs);
+    free(trees.refs);
+    freeFlatAst(&flat);
+    freeDiagnostics(&diagnostics);
+    freeArena(&arena);
+    freeTokensList(&tokens);
+    closeSourceFile(&source);
+    return 0;
+}
@@ -0,0 +1,135 @@
+#include "Bench.h"
+#include "Token.h"
+
+#include <libk/Errors.h>
+#include <string.h>
+
+/**
+ * Keyword recognition: findKeywordOrIdent against the switch on the first character followed by a chain of
+ * compareCString calls that it replaced, on a mix of identifiers and keywords like the lexer sees.
+ */
+
+#define KEYWORDS_WORDS 4096
+#define KEYWORDS_LOOKUPS 20000000
+
+static TokenType chainFindKeywordOrIdent(String keyword) {
+    ILLEGAL(keyword.len == 0, "Empty String");
+
+    switch (keyword.data[0]) {
+        case 'a':
+            if (compareCString(&keyword, "auto")) return TOK_AUTO;
+            break;
+        case 'b':
+            if (compareCString(&keyword, "bool")) return TOK_BOOL;
+            if (compareCString(&keyword, "break")) return TOK_BREAK;
+            break;
+        case 'c':
+            if (compareCString(&keyword, "case")) return TOK_CASE;
+            if (compareCString(&keyword, "const")) return TOK_CONST;
+            if (compareCString(&keyword, "continue")) return TOK_CONTINUE;
+            break;
+        case 'd':
+            if (compareCString(&keyword, "default")) return TOK_DEFAULT;
+            if (compareCString(&keyword, "do")) return TOK_DO;
+            break;
+        case 'e':
+            if (compareCString(&keyword, "else")) return TOK_ELSE;
+            if (compareCString(&keyword, "enum")) return TOK_ENUM;
+            if (compareCString(&keyword, "extern")) return TOK_EXTERN;
+            break;
+        case 'f':
+            if (compareCString(&keyword, "f32")) return TOK_F32;
+            if (compareCString(&keyword, "f64")) return TOK_F64;
+            if (compareCString(&keyword, "for")) return TOK_FOR;
+            break;
+        case 'i':
+            if (compareCString(&keyword, "i16")) return TOK_I16;
+            if (compareCString(&keyword, "i32")) return TOK_I32;
+            if (compareCString(&keyword, "i64")) return TOK_I64;
+            if (compareCString(&keyword, "i8")) return TOK_I8;
+            if (compareCString(&keyword, "if")) return TOK_IF;
+            break;
+        case 'r':
+            if (compareCString(&keyword, "return")) return TOK_RETURN;
+            break;
+        case 's':
+            if (compareCString(&keyword, "static")) return TOK_STATIC;
+            if (compareCString(&keyword, "struct")) return TOK_STRUCT;
+            if (compareCString(&keyword, "switch")) return TOK_SWITCH;
+            break;
+        case 't':
+            if (compareCString(&keyword, "typedef")) return TOK_TYPEDEF;
+            break;
+        case 'u':
+            if (compareCString(&keyword, "u16")) return TOK_U16;
+            if (compareCString(&keyword, "u32")) return TOK_U32;
+            if (compareCString(&keyword, "u64")) return TOK_U64;
+            if (compareCString(&keyword, "u8")) return TOK_U8;
+            if (compareCString(&keyword, "union")) return TOK_UNION;
+            break;
+        case 'v':
+            if (compareCString(&keyword, "void")) return TOK_VOID;
+            break;
+        case 'w':
+            if (compareCString(&keyword, "while")) return TOK_WHILE;
+    }
+
+    return TOK_IDENTIFIER;
+}
+
+// Three identifiers for every keyword, many of them sharing a first character with one
+static cstr pool[] = {
+    "auto",     "bool",     "break",    "case",     "const",    "continue", "default",  "do",       "else",
+    "enum",     "extern",   "f32",      "f64",      "for",      "i16",      "i32",      "i64",      "i8",
+    "if",       "return",   "static",   "struct",   "switch",   "typedef",  "u16",      "u32",      "u64",
+    "u8",       "union",    "void",     "while",    "i",        "j",        "n",        "x",        "count",
+    "index",    "value",    "result",   "buffer",   "size",     "data",     "next",     "offset",   "len",
+    "cap",      "arena",    "token",    "source",   "parser",   "expr",     "stmt",     "type",     "left",
+    "right",    "lhs",      "rhs",      "op",       "tmp",      "state",    "config",   "entry",    "table",
+    "slot",     "key",      "hash",     "line",     "col",      "begin",    "end",      "first",    "last",
+    "width",    "height",   "flags",    "mask",     "bits",     "byte",     "chars",    "depth",    "scope",
+    "symbol",   "name",     "label",    "target",   "limit",    "total",    "delta",    "base",     "ptr",
+    "dest",     "src",      "input",    "output",   "error",    "status",   "handle",   "node",     "child",
+    "parent",   "stack",    "queue",    "list",     "map",      "set",      "iter",     "cursor",   "window",
+    "frame",    "event",    "timer",    "clock",    "seed",     "random",   "sample",   "matrix",   "vector",
+    "point",    "rect",     "color",
+};
+
+static f64 timeLookups(TokenType (*find)(String), const String *words) {
+    f64 best = 1e30;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        u64 sum = 0;
+        f64 start = benchSeconds();
+        for (usize i = 0; i < KEYWORDS_LOOKUPS; i++) sum += find(words[i % KEYWORDS_WORDS]);
+        f64 seconds = benchSeconds() - start;
+        benchSink += sum;
+        if (seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(void) {
+    usize poolSize = sizeof(pool) / sizeof(pool[0]);
+    for (usize i = 0; i < poolSize; i++) {
+        String word = {.data = (u8 *)pool[i], .len = strlen(pool[i])};
+        if (findKeywordOrIdent(word) != chainFindKeywordOrIdent(word)) {
+            fprintf(stderr, "findKeywordOrIdent disagrees with the chain on \"%s\"\n", pool[i]);
+            return 1;
+        }
+    }
+
+    String *words = malloc(KEYWORDS_WORDS * sizeof(String));
+    if (words == NULL) exit(1);
+    u64 seed = 4;
+    for (usize i = 0; i < KEYWORDS_WORDS; i++) {
+        cstr word = pool[benchRandom(&seed) % poolSize];
+        words[i] = (String){.data = (u8 *)word, .len = strlen(word)};
+    }
+
+    printf("keywords: %d lookups, best of %d runs\n", KEYWORDS_LOOKUPS, BENCH_RUNS);
+    benchReport("first character + compareCString", timeLookups(chainFindKeywordOrIdent, words), KEYWORDS_LOOKUPS,
+                "lookup");
+    benchReport("findKeywordOrIdent", timeLookups(findKeywordOrIdent, words), KEYWORDS_LOOKUPS, "lookup");
+    free(words);
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "Bench.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "TokenClasses.h"
+
+#include <libk/StringBuilder.h>
+
+/**
+ * Parser throughput on expression heavy input: declarations initialized with randomly nested binary, unary and
+ * conditional expressions, and the cost of testing every token against all of the parser's token classes.
+ * `make bench` builds this twice, once as is and once with -DTOKEN_CLASS_VARIADIC against a parser built the same way,
+ * so parse is timed with TokenSet bit tests and with the variadic match the parser used before, see TokenClasses.h.
+ */
+
+#ifdef TOKEN_CLASS_VARIADIC
+#define PARSER_CLASS_TEST "variadic match"
+#else
+#define PARSER_CLASS_TEST "TokenSet"
+#endif
+
+#define PARSER_DECLARATIONS 5000
+#define PARSER_MAX_DEPTH 12
+
+static cstr binaryOps[] = {"+",  "-",  "*",  "/", "%", "<<", ">>", "<", "<=", ">",
+                           ">=", "==", "!=", "&", "^", "|",  "&&", "||"};
+static cstr unaryOps[] = {"-", "!", "~"};
+
+static void emit(StringBuilder *out, cstr text) {
+    while (*text != '\0') joinByte(out, (u8)*text++);
+}
+
+static void emitNumber(StringBuilder *out, cstr prefix, u64 value) {
+    char digits[32];
+    snprintf(digits, sizeof(digits), "%s%llu", prefix, (unsigned long long)value);
+    emit(out, digits);
+}
+
+static void emitExpr(StringBuilder *out, u64 *seed, usize depth) {
+    u64 pick = benchRandom(seed) % 16;
+    if (depth == 0 || pick < 3) {
+        if (pick % 2 == 0)
+            emitNumber(out, "", benchRandom(seed) % 1000);
+        else
+            emitNumber(out, "v", benchRandom(seed) % 64);
+        return;
+    }
+    if (pick < 5) {
+        emit(out, unaryOps[benchRandom(seed) % (sizeof(unaryOps) / sizeof(unaryOps[0]))]);
+        emitExpr(out, seed, depth - 1);
+    } else if (pick < 7) {
+        emit(out, "(");
+        emitExpr(out, seed, depth - 1);
+        emit(out, ")");
+    } else if (pick < 8) {
+        emitExpr(out, seed, depth - 1);
+        emit(out, " ? ");
+        emitExpr(out, seed, depth - 1);
+        emit(out, " : ");
+        emitExpr(out, seed, depth - 1);
+    } else {
+        emitExpr(out, seed, depth - 1);
+        emit(out, " ");
+        emit(out, binaryOps[benchRandom(seed) % (sizeof(binaryOps) / sizeof(binaryOps[0]))]);
+        emit(out, " ");
+        emitExpr(out, seed, depth - 1);
+    }
+}
+
+static f64 timeParse(const SourceFile *source, TokensList tokens) {
+    f64 best = 1e30;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        Arena arena = {0};
+        Diagnostics diagnostics = {0};
+        f64 start = benchSeconds();
+        StmtList list = parse(&arena, source, tokens, &diagnostics);
+        f64 seconds = benchSeconds() - start;
+        benchSink += list.len;
+        freeArena(&arena);
+        freeDiagnostics(&diagnostics);
+        if (seconds < best) best = seconds;
+    }
+    return best;
+}
+
+#define COUNT_TOKEN_CLASS_(list) +TOKEN_CLASS_HAS(list, type)
+
+// Number of classes in TokenClasses.h the token belongs to
+static usize tokenClasses(TokenType type) { return 0 TOKEN_CLASSES(COUNT_TOKEN_CLASS_); }
+
+static f64 timeClasses(TokensList tokens) {
+    f64 best = 1e30;
+    for (usize run = 0; run < BENCH_RUNS; run++) {
+        u64 matches = 0;
+        f64 start = benchSeconds();
+        for (usize i = 0; i < tokens.len; i++) matches += tokenClasses(tokens.arr[i].type);
+        f64 seconds = benchSeconds() - start;
+        benchSink += matches;
+        if (seconds < best) best = seconds;
+    }
+    return best;
+}
+
+int main(void) {
+    StringBuilder text = {0};
+    u64 seed = 13;
+    for (usize i = 0; i < PARSER_DECLARATIONS; i++) {
+        emitNumber(&text, "i32 v", i % 64);
+        emit(&text, " = ");
+        emitExpr(&text, &seed, PARSER_MAX_DEPTH);
+        emit(&text, ";\n");
+    }
+    SourceFile source = {.contents = moveToString(&text)};
+    buildLineIndex(&source);
+
+    TokensList tokens = {0};
+    if (!scanSource(&tokens, &source)) {
+        fprintf(stderr, "Generated source doesn't lex\n");
+        return 1;
+    }
+
+    printf("parser, %s: %zu tokens in %zu bytes, best of %d runs\n", PARSER_CLASS_TEST, tokens.len,
+           source.contents.len, BENCH_RUNS);
+    Arena arena = {0};
+    Diagnostics diagnostics = {0};
+    StmtList list = parse(&arena, &source, tokens, &diagnostics);
+    Bool parsed = list.len == PARSER_DECLARATIONS && diagnostics.len == 0;
+    freeArena(&arena);
+    freeDiagnostics(&diagnostics);
+    if (!parsed) {
+        fprintf(stderr, "Generated source doesn't parse\n");
+        return 1;
+    }
+    benchReport("parse", timeParse(&source, tokens), tokens.len, "token");
+    benchReport("token classes", timeClasses(tokens), tokens.len, "token");
+
+    free(tokens.arr);
+    closeSourceFile(&source);
+    return 0;
+}
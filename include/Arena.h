@@ -0,0 +1,57 @@
+#ifndef INCLUDE_KC_ARENA_H_
+#define INCLUDE_KC_ARENA_H_
+
+#include <libk/Types.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Bump allocator owning everything built for one translation unit.
+ * Nodes are never freed one by one, the whole unit goes away with a single freeArena. A zeroed Arena is empty and
+ * ready to use.
+ * Every allocation is tagged with what it holds so the arena can report per kind statistics.
+ */
+
+#define ARENA_TAG_LIST                                                                                                 \
+    X(ARENA_EXPR, "expr")                                                                                              \
+    X(ARENA_STMT, "stmt")                                                                                              \
+    X(ARENA_TYPE, "type")                                                                                              \
+    X(ARENA_LIST, "list")
+
+typedef enum {
+#define X(tag, name) tag,
+    ARENA_TAG_LIST
+#undef X
+    ARENA_TAG_COUNT,
+} ArenaTag;
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head; // Block being bumped, older blocks hang off it
+    usize blockCount;
+    usize reserved;
+    usize used;
+    usize counts[ARENA_TAG_COUNT];
+    usize bytes[ARENA_TAG_COUNT];
+} Arena;
+
+void *arenaAlloc(Arena *arena, ArenaTag tag, usize size);
+void *arenaCopy(Arena *arena, ArenaTag tag, const void *src, usize size);
+void freeArena(Arena *arena);
+// Hand every block of `src` over to `dest`, which then owns everything allocated from `src`. `src` is left empty.
+void mergeArena(Arena *dest, Arena *src);
+void printArenaStats(FILE *out, const Arena *arena);
+
+#define ARENA_NEW(arena, tag, T) ((T *)arenaAlloc((arena), (tag), sizeof(T)))
+
+// Move a list built with appendSingle into the arena. The list must not grow afterwards.
+#define ARENA_ADOPT_LIST(arena, list)                                                                                  \
+    do {                                                                                                               \
+        void *adopted = arenaCopy((arena), ARENA_LIST, (list)->arr, (list)->len * sizeof(*(list)->arr));               \
+        free((list)->arr);                                                                                             \
+        (list)->arr = adopted;                                                                                         \
+        (list)->cap = (list)->len;                                                                                     \
+    } while (0)
+
+#endif // INCLUDE_KC_ARENA_H_
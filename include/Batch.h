@@ -0,0 +1,26 @@
+#ifndef INCLUDE_KC_BATCH_H_
+#define INCLUDE_KC_BATCH_H_
+
+#include "Bytecode.h"
+
+/**
+ * Columnar evaluation of one expression over many rows.
+ * Rows are taken in blocks, and every bytecode instruction runs as a loop of SIMD vector operations over the whole
+ * block, so dispatch is paid once per block instead of once per row. With GCC and clang on x86-64 Linux the loops are
+ * also built for AVX2, picked at load time when the CPU has it. A ?: whose condition differs between rows of a block
+ * sends that block through runBytecode row by row, as do the rows left over after the last full block.
+ * Results are exactly those of runBytecode on every row.
+ */
+
+// Values of one identifier, one per row
+typedef struct {
+    Symbol name;
+    const int *values;
+} BatchColumn;
+
+// columns[i] holds the values of code->variables.arr[i], `out` gets one result per row
+void runBytecodeBatch(const Bytecode *code, const int *const *columns, usize rows, int *out);
+// Returns FALSE if the expression can't be compiled, see compileExpr, or reads an identifier without a column
+Bool evalExprBatch(const Expr *root, const BatchColumn *columns, usize columnCount, usize rows, int *out);
+
+#endif // INCLUDE_KC_BATCH_H_
@@ -0,0 +1,80 @@
+#ifndef INCLUDE_KC_BYTECODE_H_
+#define INCLUDE_KC_BYTECODE_H_
+
+#include "Expression.h"
+
+/**
+ * Register bytecode for evaluating the same expression many times.
+ * compileExpr turns an Expr into three address instructions over one register file: the constants come first, then
+ * one register per variable the expression reads, then the temporaries. Leaves never cost an instruction, operators
+ * read their operands straight from the register that holds them. Temporaries are handed out like a stack, so a
+ * result reuses the register of its first operand and deep left leaning trees need only a couple of them.
+ * runBytecode computes exactly what evalExpr does, in int arithmetic, with identifiers bound to the values in `env`.
+ * It also takes the comma operator, which evalExpr doesn't implement yet.
+ */
+
+// Binary opcodes, the operator they compile from and the C operator they apply
+#define BYTECODE_BINARY_LIST                                                                                           \
+    X(OP_ADD,           TOK_PLUS,                +)                                                                    \
+    X(OP_SUB,           TOK_MINUS,               -)                                                                    \
+    X(OP_MUL,           TOK_STAR,                *)                                                                    \
+    X(OP_DIV,           TOK_SLASH,               /)                                                                    \
+    X(OP_MOD,           TOK_PERCENT,             %)                                                                    \
+    X(OP_BIT_AND,       TOK_AMPERSAND,           &)                                                                    \
+    X(OP_BIT_XOR,       TOK_CARET,               ^)                                                                    \
+    X(OP_BIT_OR,        TOK_PIPE,                |)                                                                    \
+    X(OP_SHL,           TOK_LESS_LESS,           <<)                                                                   \
+    X(OP_SHR,           TOK_GREATER_GREATER,     >>)                                                                   \
+    X(OP_OR,            TOK_PIPE_PIPE,           ||)                                                                   \
+    X(OP_AND,           TOK_AMPERSAND_AMPERSAND, &&)                                                                   \
+    X(OP_EQUAL,         TOK_EQUALS_EQUALS,       ==)                                                                   \
+    X(OP_NOT_EQUAL,     TOK_BANG_EQUALS,         !=)                                                                   \
+    X(OP_LESS,          TOK_LESS,                <)                                                                    \
+    X(OP_LESS_EQUAL,    TOK_LESS_EQUALS,         <=)                                                                   \
+    X(OP_GREATER,       TOK_GREATER,             >)                                                                    \
+    X(OP_GREATER_EQUAL, TOK_GREATER_EQUALS,      >=)
+
+typedef enum {
+    OP_RETURN,        // return a
+    OP_MOVE,          // dest = a
+    OP_JUMP,          // continue at instruction b
+    OP_JUMP_IF_FALSE, // continue at instruction b if a is 0
+    OP_NEG,           // dest = -a
+    OP_BIT_NOT,       // dest = ~a
+    OP_NOT,           // dest = !a
+#define X(opcode, token, operator) opcode, // dest = a operator b
+    BYTECODE_BINARY_LIST
+#undef X
+    OPCODE_COUNT,
+} Opcode;
+
+typedef struct {
+    u32 op; // Opcode
+    u32 dest;
+    u32 a;
+    u32 b;
+} Instruction;
+
+typedef struct {
+    struct {
+        LIST_FIELDS(Instruction);
+    } code;
+    struct {
+        LIST_FIELDS(int);
+    } constants; // Initial values of the first registers
+    struct {
+        LIST_FIELDS(Symbol);
+    } variables; // Identifier bound to each register after the constants
+    usize registerCount;
+} Bytecode;
+
+// Returns FALSE and leaves `code` empty if the expression has a node evalExpr can't evaluate either: calls, indexing,
+// members, unary & and *, or literals other than integers
+Bool compileExpr(Bytecode *code, const Expr *root);
+// Index of `name` in the environment, -1 if the expression doesn't read it
+i64 bytecodeVariable(const Bytecode *code, Symbol name);
+// `env` holds the value of every entry of code->variables, in the same order
+int runBytecode(const Bytecode *code, const int *env);
+void freeBytecode(Bytecode *code);
+
+#endif // INCLUDE_KC_BYTECODE_H_
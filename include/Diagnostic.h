@@ -0,0 +1,31 @@
+#ifndef INCLUDE_KC_DIAGNOSTIC_H_
+#define INCLUDE_KC_DIAGNOSTIC_H_
+
+#include "Source.h"
+
+#include <libk/List.h>
+#include <stdio.h>
+
+/**
+ * Errors collected while compiling one translation unit.
+ * Passes record what they find and carry on instead of stopping at the first problem, so one run reports everything.
+ * Messages are static strings and are not owned by the list. A zeroed Diagnostics is empty and has no limit.
+ */
+
+typedef struct {
+    u32 offset;
+    cstr message;
+} Diagnostic;
+
+typedef struct {
+    LIST_FIELDS(Diagnostic);
+    usize limit;    // Maximum number of diagnostics to keep, 0 for no limit
+    Bool truncated; // An error was dropped because the limit had been reached
+} Diagnostics;
+
+// Record an error at `offset`. Returns FALSE once the limit has been reached and the caller should stop.
+Bool reportDiagnostic(Diagnostics *diagnostics, u32 offset, cstr message);
+void printDiagnostics(FILE *out, const SourceFile *source, const Diagnostics *diagnostics);
+void freeDiagnostics(Diagnostics *diagnostics);
+
+#endif // INCLUDE_KC_DIAGNOSTIC_H_
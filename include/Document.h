@@ -0,0 +1,59 @@
+#ifndef INCLUDE_KC_DOCUMENT_H_
+#define INCLUDE_KC_DOCUMENT_H_
+
+#include "Diagnostic.h"
+#include "Parser.h"
+
+/**
+ * A source file kept parsed across edits, for editor integration.
+ * The text is split into top level statements, each running from its first token up to the next statement. An entry
+ * only records its own length, token count and diagnostics, nothing that depends on what comes before it, so an edit
+ * leaves the statements past it alone. Absolute starts and token indices are worked out from the lengths when they are
+ * needed and cached up to the furthest entry looked at.
+ * An edit relexes and reparses from the statement before the one it starts in until the parser is back at the start
+ * of an old statement past the edit. Everything from there on is reused as it is: its Stmt nodes, tokens and
+ * diagnostics keep the offsets they had when they were parsed, and are only moved once somebody asks for them through
+ * documentStatement, documentStatements, documentTokens or documentDiagnostics.
+ * Lexing, parsing and allocating are proportional to the statements an edit touches. What still grows with the file
+ * is moving the flat arrays along at memmove speed: the text, the tokens, the statement table and the line index,
+ * whose later line starts editSourceFile also adjusts.
+ * Replaced statements stay in the arena until the document is closed.
+ */
+
+typedef struct {
+    Stmt *stmt;              // NULL if the statement had errors
+    Diagnostics diagnostics; // Reported while parsing the statement
+    u32 length;              // Bytes up to the next statement, or to the end of the text for the last one
+    u32 tokenCount;          // Tokens up to the next statement, or to the end of the text
+    u32 base;                // Start of the statement when the offsets of its nodes, tokens and diagnostics were set
+    u32 start;               // Cached from the lengths, only valid below Document.knownEntries
+    u32 firstToken;          // Index in the document's tokens, cached like `start`
+} DocumentEntry;
+
+typedef struct {
+    SourceFile source;
+    TokensList tokens; // Offsets are only up to date for statements that have been asked for, see documentTokens
+    struct {
+        LIST_FIELDS(DocumentEntry);
+    } entries;
+    u32 leading;             // Whitespace and comments before the first statement
+    usize knownEntries;      // Entries whose `start` and `firstToken` are cached
+    Arena arena;
+    StmtList statements;     // Filled in by documentStatements
+    Diagnostics diagnostics; // Filled in by documentDiagnostics
+} Document;
+
+ErrCode openDocument(Document *doc, cstr path);
+// Replace bytes [start, end) of the text with `text` and bring tokens, statements and diagnostics up to date
+ErrCode editDocument(Document *doc, u32 start, u32 end, String text);
+// Top level statement `index` in source order, NULL if it had errors
+Stmt *documentStatement(Document *doc, usize index);
+// Every statement without errors, what parse would return for the current text. Valid until the next edit.
+StmtList documentStatements(Document *doc);
+// What scanSource would return for the current text. Valid until the next edit.
+TokensList documentTokens(Document *doc);
+// In source order, what parse would report for the current text. Valid until the next edit.
+Diagnostics documentDiagnostics(Document *doc);
+void closeDocument(Document *doc);
+
+#endif // INCLUDE_KC_DOCUMENT_H_
@@ -22,7 +22,22 @@
  * 17. expression;
  */
 
+#include "Arena.h"
 #include "Token.h"
+#include "Walk.h"
+
+// Compound assignments and the binary operator they apply
+#define COMPOUND_ASSIGNMENT_LIST                                                                                       \
+    X(TOK_PLUS_EQUALS,            TOK_PLUS)                                                                            \
+    X(TOK_MINUS_EQUALS,           TOK_MINUS)                                                                           \
+    X(TOK_STAR_EQUALS,            TOK_STAR)                                                                            \
+    X(TOK_SLASH_EQUALS,           TOK_SLASH)                                                                           \
+    X(TOK_PERCENT_EQUALS,         TOK_PERCENT)                                                                         \
+    X(TOK_AMPERSAND_EQUALS,       TOK_AMPERSAND)                                                                       \
+    X(TOK_CARET_EQUALS,           TOK_CARET)                                                                           \
+    X(TOK_PIPE_EQUALS,            TOK_PIPE)                                                                            \
+    X(TOK_LESS_LESS_EQUALS,       TOK_LESS_LESS)                                                                       \
+    X(TOK_GREATER_GREATER_EQUALS, TOK_GREATER_GREATER)
 
 typedef struct Expr Expr;
 
@@ -35,10 +50,17 @@ typedef enum {
     EXPR_INDEX,
     EXPR_FUNC_CALL,
     EXPR_MEMBER,
+    EXPR_COMPOUND_ASSIGN,
+    EXPR_INCREMENT,
+    EXPR_CONSTANT,
 } ExprType;
 
+// Identifier that hasn't been resolved, or a literal other than an identifier
+#define NO_DECLARATION U32_MAX
+
 typedef struct {
     Token value;
+    u32 declaration; // Of an identifier, its index in the SymbolTable that resolved it (see Resolve.h)
 } PrimaryExpr;
 
 typedef struct {
@@ -82,6 +104,33 @@ typedef struct {
     Token member;
 } MemberExpr;
 
+typedef struct {
+    TokenType op; // The assignment token, TOK_PLUS_EQUALS for +=
+    Expr *target;
+    Expr *value;
+} CompoundAssignExpr;
+
+typedef struct {
+    TokenType op; // TOK_PLUS_PLUS or TOK_MINUS_MINUS
+    u32 offset;   // Of the operator
+    Bool isPrefix;
+    Expr *target;
+} IncrementExpr;
+
+// Typed value of a folded expression, see Fold.h
+typedef struct {
+    TokenType type; // One of the primitive type keywords TOK_BOOL, TOK_U8 ... TOK_F64
+    union {
+        u64 integer; // Sign extended to 64 bits for the signed types
+        f64 real;    // Already rounded to float for f32
+    } as;
+} Constant;
+
+typedef struct {
+    Constant value;
+    u32 offset; // Of the first token of the expression that was folded
+} ConstantExpr;
+
 struct Expr {
     ExprType type;
     union {
@@ -93,23 +142,47 @@ struct Expr {
         IndexExpr index;
         FuncCallExpr funcCall;
         MemberExpr member;
+        CompoundAssignExpr compoundAssign;
+        IncrementExpr increment;
+        ConstantExpr constant;
     } as;
 };
 
-Expr *makePrimaryExpr(Token value);
-Expr *makeGroupingExpr(Expr *inner);
-Expr *makeBinaryExpr(TokenType op, Expr *lhs, Expr *rhs);
-Expr *makeUnaryExpr(TokenType op, Expr *inner);
-Expr *makeConditionalExpr(Expr *condition, Expr *thenBranch, Expr *elseBranch);
-Expr *makeIndexExpr(Expr *name, Expr *index);
-Expr *makeFuncCallExpr(Expr *name, ArgsList args);
-Expr *makeMemberExpr(TokenType op, Expr *object, Token ident);
+Expr *makePrimaryExpr(Arena *arena, Token value);
+Expr *makeGroupingExpr(Arena *arena, Expr *inner);
+Expr *makeBinaryExpr(Arena *arena, TokenType op, Expr *lhs, Expr *rhs);
+Expr *makeUnaryExpr(Arena *arena, TokenType op, Expr *inner);
+Expr *makeConditionalExpr(Arena *arena, Expr *condition, Expr *thenBranch, Expr *elseBranch);
+Expr *makeIndexExpr(Arena *arena, Expr *name, Expr *index);
+Expr *makeFuncCallExpr(Arena *arena, Expr *name, ArgsList args);
+Expr *makeMemberExpr(Arena *arena, TokenType op, Expr *object, Token ident);
+Expr *makeCompoundAssignExpr(Arena *arena, TokenType op, Expr *target, Expr *value);
+Expr *makeIncrementExpr(Arena *arena, Token op, Bool isPrefix, Expr *target);
+Expr *makeConstantExpr(Arena *arena, Constant value, u32 offset);
+
+// Binary operator applied by a compound assignment, TOK_PLUS for TOK_PLUS_EQUALS
+TokenType compoundAssignOperator(TokenType op);
+
+// Children of `expr` in evaluation order, NULL past the last one. Lets walk visitors that treat every kind of node
+// alike step through the children without a switch of their own.
+const Expr *exprChild(const Expr *expr, u32 i);
 
 int evalExpr(Expr *root);
-Expr *cloneExpr(Expr *src);
-void printExprImpl(Expr *root, usize indent);
-void printExpr(Expr *root);
-void freeExpr(Expr *e);
+// Apply an arithmetic, bitwise, logical or comparison operator to already evaluated operands
+int evalBinaryOperator(TokenType op, int lhs, int rhs);
+Expr *cloneExpr(Arena *arena, Expr *src);
+// Move every token in the tree by `delta` bytes. Shared nodes (see Lower.h) would be moved more than once.
+void shiftExpr(Expr *root, i64 delta);
+void printExprImpl(const SourceFile *source, Expr *root, usize indent);
+// Walk visitor behind printExprImpl, for printers of nodes that contain expressions. `ctx` is the SourceFile and the
+// node data its indentation.
+Bool printExprStep(void *ctx, WalkNode node, u32 step, WalkNode *child);
+void printExpr(const SourceFile *source, Expr *root);
+// Same format as printToken
+void printConstant(const SourceFile *source, Constant value, u32 offset);
+// The int evalExpr and the bytecode compute a constant with. Integers wrap like any other int conversion, reals are
+// truncated and saturate at INT_MIN and INT_MAX, NaN gives 0.
+int constantToInt(Constant value);
 
 extern cstr tokenTypesStrings[];
 
@@ -0,0 +1,62 @@
+#ifndef INCLUDE_KC_FLAT_AST_H_
+#define INCLUDE_KC_FLAT_AST_H_
+
+#include "Expression.h"
+
+/**
+ * Index based expression trees.
+ * Nodes live in one contiguous array and refer to their children by u32 index, tokens are referred to by index into
+ * the tree's own token array instead of being copied into every node. That array is a private copy rather than the
+ * lexer's TokensList: an Expr holds its tokens by value and doesn't know where they came from, trees parsed from a
+ * compact token stream have no TokensList at all, lowering creates tokens that were never lexed, and a FlatAst may
+ * outlive the list the tokens were scanned into. Only leaves and member names are copied, one Token per use.
+ * Children are always stored before their parents, so a walk over the array in order visits every node after its
+ * operands.
+ * flattenExpr converts a pointer based Expr, the flat walkers mirror evalExpr and printExprImpl. All of them go through
+ * walk, so nesting depth is only limited by memory.
+ */
+
+typedef u32 FlatRef;
+
+#define FLAT_NONE U32_MAX
+
+typedef struct {
+    u8 type; // ExprType
+    u8 op;   // TokenType of binary, unary and member nodes
+    // Meaning depends on the type:
+    //     literal:     token
+    //     grouping:    inner
+    //     binary:      lhs, rhs
+    //     unary:       inner
+    //     conditional: condition, then, else
+    //     index:       name, index
+    //     func call:   callee, first argument in `args`, argument count
+    //     member:      object, member token
+    //     compound:    target, value
+    //     increment:   target, prefix flag, operator offset
+    //     constant:    offset, low and high half of the value, its type in `op`
+    u32 a;
+    u32 b;
+    u32 c;
+} FlatNode;
+
+typedef struct {
+    struct {
+        LIST_FIELDS(FlatNode);
+    } nodes;
+    struct {
+        LIST_FIELDS(FlatRef);
+    } args;
+    TokensList tokens;
+} FlatAst;
+
+_Static_assert(TOKEN_TYPE_COUNT <= U8_MAX, "FlatNode stores operators in a u8");
+
+// Append `root` and its subtree to `ast`, returns the index of the root node or FLAT_NONE for a NULL expression
+FlatRef flattenExpr(FlatAst *ast, const Expr *root);
+int evalFlatExpr(const FlatAst *ast, FlatRef root);
+void printFlatExprImpl(const SourceFile *source, const FlatAst *ast, FlatRef root, usize indent);
+void printFlatExpr(const SourceFile *source, const FlatAst *ast, FlatRef root);
+void freeFlatAst(FlatAst *ast);
+
+#endif // INCLUDE_KC_FLAT_AST_H_
@@ -0,0 +1,25 @@
+#ifndef INCLUDE_KC_FOLD_H_
+#define INCLUDE_KC_FOLD_H_
+
+#include "Diagnostic.h"
+#include "Statement.h"
+
+/**
+ * Constant folding pass, run after parsing and before lowering.
+ * Every operator whose operands are all numeric literals or already folded becomes a single EXPR_CONSTANT node
+ * holding a typed value, so later passes never evaluate the same constant tree again. Types follow C:
+ *     - integer literals are i32 if they fit, i64 or u64 otherwise, float literals f64 and char literals u8
+ *     - operands narrower than 32 bits are promoted to i32 and mixed operands converted to their common type
+ *     - unsigned arithmetic wraps at the type's width, f32 results are rounded to float
+ *     - comparisons and logical operators produce an i32 0 or 1
+ * Signed overflow, integer division by zero, shifts out of range and bitwise operators on floats are reported, and
+ * the offending operator is left as it is. Float division by zero gives the IEEE result.
+ * Initializers of variables with a primitive type are converted to that type. One that doesn't fit is reported and
+ * converted all the same, integers wrap to the width of the type and reals out of its range become 0 (infinite for
+ * f32). Array sizes must be non negative integers. Nodes are rewritten in place, folding a lowered tree would report
+ * errors in shared nodes twice.
+ */
+void foldExpr(Expr *root, Diagnostics *diagnostics);
+void foldStmtList(StmtList list, Diagnostics *diagnostics);
+
+#endif // INCLUDE_KC_FOLD_H_
@@ -0,0 +1,47 @@
+#ifndef INCLUDE_KC_INTERNER_H_
+#define INCLUDE_KC_INTERNER_H_
+
+#include <libk/List.h>
+#include <libk/String.h>
+
+/**
+ * String interning.
+ * Every distinct name gets a dense Symbol id and a single stored copy, so names can be compared by id.
+ * The process wide table behind `intern` is what tokens refer to, its symbols stay valid across translation units
+ * until `freeInterner` is called. Private tables let threads intern without sharing state, their symbols are mapped
+ * into the process wide table afterwards.
+ */
+typedef u32 Symbol;
+
+typedef struct {
+    String text;
+    u32 hash;
+} InternEntry;
+
+typedef struct {
+    // Open addressing table of symbol + 1, 0 marks an empty slot
+    u32 *slots;
+    usize slotsCap;
+    // Indexed by symbol
+    struct {
+        LIST_FIELDS(InternEntry);
+    } entries;
+    // Stable storage for the interned bytes, blocks are never moved
+    struct {
+        LIST_FIELDS(u8 *);
+    } blocks;
+    usize blockUsed;
+    usize blockCap;
+} InternTable;
+
+Symbol internInto(InternTable *table, String text);
+String internTableText(const InternTable *table, Symbol symbol);
+void freeInternTable(InternTable *table);
+
+InternTable *globalInterner(void);
+Symbol intern(String text);
+String symbolText(Symbol symbol);
+usize internedCount(void);
+void freeInterner(void);
+
+#endif // INCLUDE_KC_INTERNER_H_
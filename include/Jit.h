@@ -0,0 +1,34 @@
+#ifndef INCLUDE_KC_JIT_H_
+#define INCLUDE_KC_JIT_H_
+
+#include "Bytecode.h"
+
+/**
+ * Native code for hot expressions, on x86-64 Linux.
+ * jitCompileExpr compiles the expression to bytecode and translates every instruction into a short fixed sequence of
+ * machine code: constants become immediates, variables are read straight out of `env` and temporaries live in the
+ * stack frame. The code gets a mapping of its own, which is made executable and read only once it has been written.
+ * Anywhere the code can't be generated (other targets, a failed mapping, a frame too large for the stack) the bytecode
+ * is run instead, so callers always go through jitRun. A mapping costs at least a page, compile the expressions that
+ * are evaluated often rather than all of them.
+ */
+
+typedef int (*JitFunction)(const int *env);
+
+typedef struct {
+    Bytecode bytecode;    // Also gives the order of the variables in `env`
+    JitFunction function; // NULL if the bytecode is run instead
+    void *memory;
+    usize size;
+} JitExpr;
+
+// Returns FALSE if the expression can't be compiled at all, see compileExpr
+Bool jitCompileExpr(JitExpr *jit, const Expr *root);
+void freeJitExpr(JitExpr *jit);
+
+// Same result as runBytecode
+static inline int jitRun(const JitExpr *jit, const int *env) {
+    return jit->function != NULL ? jit->function(env) : runBytecode(&jit->bytecode, env);
+}
+
+#endif // INCLUDE_KC_JIT_H_
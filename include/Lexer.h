@@ -1,12 +1,78 @@
 #ifndef INCLUDE_INCLUDE_LEXER_H_
 #define INCLUDE_INCLUDE_LEXER_H_
 
+#include "Scan.h"
+#include "Source.h"
 #include "Token.h"
 #include <libk/String.h>
+#include <libk/StringBuilder.h>
 #include <libk/Errors.h>
 
-Bool scanFile(TokensList *dest, cstr path);
+// Must be a power of two. A single lexeme emits at most two tokens (an escape error and its literal).
+#define TOKEN_RING_SIZE 8
+#define TOKEN_STREAM_MAX_LOOKAHEAD (TOKEN_RING_SIZE - 2)
+
+typedef struct {
+    Token slots[TOKEN_RING_SIZE];
+    usize head;
+    usize count;
+} TokenRing;
+
+typedef struct {
+    String input;
+    String fileName;
+    usize index;
+    usize start; // Start of the lexeme being scanned
+    // Tokens go to `tokens` when lexing a whole file and to `ring` when streaming
+    TokensList *tokens;
+    TokenRing *ring;
+    InternTable *interner;
+    const Scanner *scan;
+    StringBuilder scratch;
+    Bool hasErros;
+} Lexer;
+
+/**
+ * Pull based token source for the parser.
+ * A live stream lexes on demand and only keeps a ring of lookahead tokens, so memory stays bounded regardless of the
+ * size of the file. List and compact streams replay an already lexed TokensList or CompactTokensList through the same
+ * interface.
+ * Once the input is exhausted every call returns a TOK_EOF token.
+ */
+typedef struct {
+    const SourceFile *source;
+    Lexer lexer;
+    TokenRing ring;
+    const TokensList *list;
+    const CompactTokensList *compact;
+    usize listIndex;
+    usize payloadIndex;
+    Token eof;
+} TokenStream;
+
+// Lex an already opened source. Tokens may refer into `source`, which must outlive them.
+Bool scanSource(TokensList *dest, const SourceFile *source);
+// Open `path` into `source` and lex it. The caller closes `source` once it is done with the tokens.
+Bool scanFile(TokensList *dest, SourceFile *source, cstr path);
+// Lex large sources on up to `threads` threads, chunked at line boundaries. Appends to `dest` like scanSource.
+Bool scanSourceParallel(TokensList *dest, const SourceFile *source, usize threads);
+// Lex into struct of arrays storage
+Bool scanSourceCompact(CompactTokensList *dest, const SourceFile *source);
 void freeTokensList(TokensList *tokens);
-void printToken(Token token);
+void printToken(const SourceFile *source, Token token);
+
+Bool openTokenStream(TokenStream *stream, const SourceFile *source);
+// Live stream that starts lexing at `offset`, which must be where a token (or the whitespace before one) starts
+Bool openTokenStreamAt(TokenStream *stream, const SourceFile *source, u32 offset);
+void openListTokenStream(TokenStream *stream, const SourceFile *source, const TokensList *tokens);
+void openCompactTokenStream(TokenStream *stream, const CompactTokensList *tokens);
+void closeTokenStream(TokenStream *stream);
+Token nextToken(TokenStream *stream);
+// Look `n` tokens past the next one without consuming anything, n must be below TOKEN_STREAM_MAX_LOOKAHEAD
+Token peekToken(TokenStream *stream, usize n);
+// Type of the token peekToken would return, without rebuilding the whole token
+TokenType peekTokenType(TokenStream *stream, usize n);
+// Whether a live stream ran into lexing errors so far
+Bool tokenStreamHasErrors(TokenStream *stream);
 
 #endif // INCLUDE_INCLUDE_LEXER_H_
@@ -0,0 +1,15 @@
+#ifndef INCLUDE_KC_LOWER_H_
+#define INCLUDE_KC_LOWER_H_
+
+#include "Statement.h"
+
+/**
+ * Desugaring pass, run after parsing.
+ * Compound assignments become a = a op b and prefix increments become a = a ± 1. Nodes are rewritten in place and the
+ * target is shared by both of its uses instead of being copied, which is safe since the arena owns every node. Later
+ * passes must not assume the result is a tree. Postfix increments produce the old value and are left as they are.
+ */
+void lowerExpr(Arena *arena, Expr *root);
+void lowerStmtList(Arena *arena, StmtList list);
+
+#endif // INCLUDE_KC_LOWER_H_
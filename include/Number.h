@@ -0,0 +1,24 @@
+#ifndef INCLUDE_KC_NUMBER_H_
+#define INCLUDE_KC_NUMBER_H_
+
+#include <libk/String.h>
+
+/**
+ * Numeric literal conversion.
+ * Both parsers work directly on the source bytes of an already delimited literal, nothing is copied or NUL terminated
+ * on the common path. Values that don't fit their type are reported instead of wrapping.
+ */
+
+typedef enum {
+    NUMBER_OK,
+    NUMBER_OUT_OF_RANGE,
+    NUMBER_BAD_DIGIT,
+    NUMBER_NO_DIGITS,
+} NumberStatus;
+
+// Value of `digits` in `base` (2, 8, 10 or 16), without any prefix
+NumberStatus parseInteger(String digits, u32 base, u64 *dest);
+// Correctly rounded value of `[0-9]* ('.' [0-9]+)? ([eE] [+-]? [0-9]+)?`
+NumberStatus parseFloat(String text, f64 *dest);
+
+#endif // INCLUDE_KC_NUMBER_H_
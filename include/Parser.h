@@ -1,8 +1,22 @@
 #ifndef INCLUDE_KC_PARSER_H_
 #define INCLUDE_KC_PARSER_H_
 
+#include "Diagnostic.h"
+#include "Lexer.h"
 #include "Statement.h"
 
-StmtList parse(TokensList tokens);
+// Parse straight from a token stream, pulling tokens as they are needed. The whole tree, including the returned list,
+// lives in `arena` and is released with it.
+// Errors don't stop the parser: each one is added to `diagnostics`, the statement it occurred in is dropped and parsing
+// resumes after the next ';' or '}'. The returned list holds every statement that parsed cleanly. Parsing stops early
+// once the diagnostics limit is reached.
+StmtList parseStream(Arena *arena, TokenStream *tokens, Diagnostics *diagnostics);
+StmtList parse(Arena *arena, const SourceFile *source, TokensList tokens, Diagnostics *diagnostics);
+// Parse a single top level statement, NULL if it had errors. The stream is left after the statement, or after the ';'
+// or '}' recovery stopped at.
+Stmt *parseStatement(Arena *arena, TokenStream *tokens, Diagnostics *diagnostics);
+// Same result as parse, with the top level statements split across up to `threads` threads
+StmtList parseParallel(Arena *arena, const SourceFile *source, TokensList tokens, Diagnostics *diagnostics,
+                       usize threads);
 
 #endif // INCLUDE_KC_PARSER_H_
@@ -0,0 +1,79 @@
+#ifndef INCLUDE_KC_RESOLVE_H_
+#define INCLUDE_KC_RESOLVE_H_
+
+#include "Diagnostic.h"
+#include "Statement.h"
+
+/**
+ * Name resolution, run after parsing and before folding.
+ * The SymbolTable records every name a VarStmt or EnumStmt declares, in a stack of scopes. Lookups go through an open
+ * addressing table keyed on the interned Symbol that always maps a name to its innermost declaration, so resolving an
+ * identifier costs one probe however deeply scopes nest. Leaving a scope puts back the declarations it shadowed.
+ * Variables and enum constants share one namespace, enum names have their own, like C tags.
+ * resolveStmtList binds every identifier in initializers and array sizes to its declaration through
+ * PrimaryExpr.declaration, and reports undeclared names and redefinitions. A variable is in scope from its own
+ * initializer on. Identifiers naming an enum constant are replaced by an i32 constant holding its value, so folding
+ * and evalExpr handle `x[N]` without a table. At file scope a variable may be declared again as long as only one of
+ * the declarations has an initializer, their types are not compared yet.
+ */
+
+typedef enum {
+    DECL_VARIABLE,
+    DECL_ENUM_CONSTANT,
+    DECL_ENUM,
+} DeclarationKind;
+
+typedef struct {
+    DeclarationKind kind;
+    Symbol name;
+    u32 offset;       // Of the declared name
+    u32 scope;        // Depth of the scope it was declared in, 0 for file scope
+    u32 shadowed;     // Declaration the name referred to before this one, NO_DECLARATION if there was none
+    Bool isDefined;   // This or an earlier declaration of the name in the same scope has an initializer
+    const Stmt *stmt; // The VarStmt or EnumStmt that declares it
+    i64 value;        // Of an enum constant
+} Declaration;
+
+typedef struct {
+    u32 key;         // Namespace and name, 0 marks an empty slot
+    u32 declaration; // Innermost declaration of the name, NO_DECLARATION once its scope has been left
+} SymbolSlot;
+
+/**
+ * A zeroed SymbolTable is an empty file scope. Declarations are never removed, indices into `declarations` stay valid
+ * after their scope has been left, until the table is freed.
+ */
+typedef struct {
+    struct {
+        LIST_FIELDS(Declaration);
+    } declarations;
+    // Declarations in the order they were bound, scopes pop theirs off the end
+    struct {
+        LIST_FIELDS(u32);
+    } bindings;
+    // Where each open scope starts in `bindings`
+    struct {
+        LIST_FIELDS(usize);
+    } scopes;
+    SymbolSlot *slots;
+    usize slotsCap;
+    usize slotsLen;
+} SymbolTable;
+
+void pushScope(SymbolTable *table);
+void popScope(SymbolTable *table);
+// Binds the name in the current scope and returns the new declaration's index. A name already declared in the current
+// scope is only rebound if redeclaring it is allowed, otherwise NO_DECLARATION is returned and nothing changes.
+u32 declareSymbol(SymbolTable *table, Declaration declaration);
+// Innermost declaration of the variable or enum constant `name`, NO_DECLARATION if it isn't in scope
+u32 lookupSymbol(const SymbolTable *table, Symbol name);
+// Same for the enum named `name`
+u32 lookupEnum(const SymbolTable *table, Symbol name);
+void freeSymbolTable(SymbolTable *table);
+
+// Resolves the identifiers in `root` against the scopes open right now
+void resolveExpr(SymbolTable *table, Expr *root, Diagnostics *diagnostics);
+// Declares the statements' names in the current scope, in order, and resolves the identifiers they contain
+void resolveStmtList(SymbolTable *table, StmtList list, Diagnostics *diagnostics);
+
+#endif // INCLUDE_KC_RESOLVE_H_
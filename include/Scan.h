@@ -0,0 +1,31 @@
+#ifndef INCLUDE_KC_SCAN_H_
+#define INCLUDE_KC_SCAN_H_
+
+#include <libk/String.h>
+
+/**
+ * Locale independent character classes and bulk scanners for the lexer hot loops.
+ * Every scanner returns the length of the longest prefix of `data` whose bytes all belong to its class.
+ */
+
+#define CHAR_BLANK 0x1 // ' ', '\t', '\r' - newlines are handled by the lexer since they end a line
+#define CHAR_DIGIT 0x2
+#define CHAR_ALPHA 0x4 // letters and '_'
+
+extern const u8 charClass[256];
+
+static inline Bool isBlankChar(u8 c) { return charClass[c] & CHAR_BLANK; }
+static inline Bool isDigitChar(u8 c) { return charClass[c] & CHAR_DIGIT; }
+static inline Bool isIdentStart(u8 c) { return charClass[c] & CHAR_ALPHA; }
+static inline Bool isIdentChar(u8 c) { return charClass[c] & (CHAR_ALPHA | CHAR_DIGIT); }
+
+typedef struct {
+    usize (*blanks)(const u8 *data, usize len);
+    usize (*identifier)(const u8 *data, usize len);
+    usize (*digits)(const u8 *data, usize len);
+} Scanner;
+
+// Pick the widest scanner the running CPU supports (AVX2, SSE2, then scalar)
+const Scanner *selectScanner(void);
+
+#endif // INCLUDE_KC_SCAN_H_
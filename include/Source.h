@@ -0,0 +1,43 @@
+#ifndef INCLUDE_KC_SOURCE_H_
+#define INCLUDE_KC_SOURCE_H_
+
+#include <libk/String.h>
+#include <libk/Errors.h>
+
+/**
+ * The contents of a single translation unit.
+ * Regular files are mapped read-only into memory, so the lexer runs directly over the mapped pages and tokens can
+ * refer back into `contents` until the source is closed. Inputs that cannot be mapped (pipes, character devices) are
+ * read into a heap buffer instead.
+ */
+typedef struct {
+    String path;
+    String contents;
+    Bool isMapped;
+    usize capacity; // Of the heap buffer holding an unmapped source
+    // Offset of the first byte of every line, built by buildLineIndex
+    u32 *lineStarts;
+    usize lineCount;
+} SourceFile;
+
+typedef struct {
+    usize line;
+    usize col;
+} SourceLocation;
+
+ErrCode openSourceFile(SourceFile *dest, cstr path);
+void closeSourceFile(SourceFile *source);
+// Replace bytes [start, end) with `text`, keeping the line index up to date. A mapped source is copied to the heap the
+// first time it is edited.
+ErrCode editSourceFile(SourceFile *source, u32 start, u32 end, String text);
+
+// Index the line starts of the source once, so byte offsets can be mapped back to lines and columns. openSourceFile
+// already does this.
+void buildLineIndex(SourceFile *source);
+// 1 based line and column of `offset`, requires the line index
+SourceLocation locateOffset(const SourceFile *source, u32 offset);
+// Same as locateOffset, but starts looking from the line in `hint` and updates it. Locating offsets in increasing
+// order is amortized O(1).
+SourceLocation locateOffsetFrom(const SourceFile *source, u32 offset, usize *hint);
+
+#endif // INCLUDE_KC_SOURCE_H_
@@ -38,11 +38,12 @@ typedef struct {
     LIST_FIELDS(Stmt *);
 } StmtList;
 
-Stmt *makeVarStmt(Type *type, StorageClass storageClass, Token identifier, Expr *initializer);
-Stmt *makeEnumStmt(Token name, TokensList entries);
+Stmt *makeVarStmt(Arena *arena, Type *type, StorageClass storageClass, Token identifier, Expr *initializer);
+Stmt *makeEnumStmt(Arena *arena, Token name, TokensList entries);
 
-Stmt *cloneStmt(Stmt *src);
-void printStmtList(StmtList list);
-void freeStmt(Stmt *e);
+Stmt *cloneStmt(Arena *arena, Stmt *src);
+// Move every token in the statement by `delta` bytes
+void shiftStmt(Stmt *stmt, i64 delta);
+void printStmtList(const SourceFile *source, StmtList list);
 
 #endif // INCLUDE_KC_STATEMENT_H_
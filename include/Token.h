@@ -1,6 +1,9 @@
 #ifndef INCLUDE_KC_TOKEN_H_
 #define INCLUDE_KC_TOKEN_H_
 
+#include "Interner.h"
+#include "Source.h"
+
 #include <libk/String.h>
 #include <libk/List.h>
 
@@ -23,7 +26,7 @@
     X(TOK_PERCENT)        /* %  */                                                                                     \
     X(TOK_PERCENT_EQUALS) /* %= */                                                                                     \
                                                                                                                        \
-    X(TOK_EQUALS_EQUALS)       /* =  */                                                                                \
+    X(TOK_EQUALS_EQUALS)       /* == */                                                                                \
     X(TOK_BANG)                /* !  */                                                                                \
     X(TOK_BANG_EQUALS)         /* != */                                                                                \
     X(TOK_LESS)                /* <  */                                                                                \
@@ -105,34 +108,161 @@
 typedef enum { TOKEN_LIST } TokenType;
 #undef X
 
+#define X(type) +1
+enum { TOKEN_TYPE_COUNT = 0 TOKEN_LIST };
+#undef X
+
+/**
+ * Set of token types, membership is a single bit test.
+ * Sets are built at compile time from a list macro taking the element macro as its parameter:
+ *     #define ADDITIVE_OPS(X) X(TOK_PLUS) X(TOK_MINUS)
+ *     static const TokenSet additiveOps = TOKEN_SET(ADDITIVE_OPS);
+ */
+#define TOKEN_SET_WORDS 3
+
+typedef struct {
+    u64 words[TOKEN_SET_WORDS];
+} TokenSet;
+
+_Static_assert(TOKEN_TYPE_COUNT <= TOKEN_SET_WORDS * 64, "TokenSet can't hold every TokenType");
+
+#define TOKEN_SET_BIT_(type, word) ((type) / 64 == (word) ? 1ull << ((type) % 64) : 0)
+#define TOKEN_SET_WORD0_(type) | TOKEN_SET_BIT_(type, 0)
+#define TOKEN_SET_WORD1_(type) | TOKEN_SET_BIT_(type, 1)
+#define TOKEN_SET_WORD2_(type) | TOKEN_SET_BIT_(type, 2)
+#define TOKEN_SET(list) {{0 list(TOKEN_SET_WORD0_), 0 list(TOKEN_SET_WORD1_), 0 list(TOKEN_SET_WORD2_)}}
+
+static inline Bool tokenSetHas(TokenSet set, TokenType type) { return (set.words[type / 64] >> (type % 64)) & 1; }
+
+/**
+ * Spelling of every punctuator. The lexer builds its operator transition table from this list, so a new operator
+ * only needs an entry here and in TOKEN_LIST.
+ */
+#define PUNCTUATOR_LIST                                                                                                \
+    X(TOK_EQUALS,                 "=")                                                                                 \
+    X(TOK_PLUS,                   "+")                                                                                 \
+    X(TOK_PLUS_PLUS,              "++")                                                                                \
+    X(TOK_PLUS_EQUALS,            "+=")                                                                                \
+    X(TOK_MINUS,                  "-")                                                                                 \
+    X(TOK_MINUS_MINUS,            "--")                                                                                \
+    X(TOK_MINUS_EQUALS,           "-=")                                                                                \
+    X(TOK_STAR,                   "*")                                                                                 \
+    X(TOK_STAR_EQUALS,            "*=")                                                                                \
+    X(TOK_SLASH,                  "/")                                                                                 \
+    X(TOK_SLASH_EQUALS,           "/=")                                                                                \
+    X(TOK_PERCENT,                "%")                                                                                 \
+    X(TOK_PERCENT_EQUALS,         "%=")                                                                                \
+    X(TOK_EQUALS_EQUALS,          "==")                                                                                \
+    X(TOK_BANG,                   "!")                                                                                 \
+    X(TOK_BANG_EQUALS,            "!=")                                                                                \
+    X(TOK_LESS,                   "<")                                                                                 \
+    X(TOK_LESS_EQUALS,            "<=")                                                                                \
+    X(TOK_GREATER,                ">")                                                                                 \
+    X(TOK_GREATER_EQUALS,         ">=")                                                                                \
+    X(TOK_AMPERSAND_AMPERSAND,    "&&")                                                                                \
+    X(TOK_PIPE_PIPE,              "||")                                                                                \
+    X(TOK_AMPERSAND,              "&")                                                                                 \
+    X(TOK_AMPERSAND_EQUALS,       "&=")                                                                                \
+    X(TOK_PIPE,                   "|")                                                                                 \
+    X(TOK_PIPE_EQUALS,            "|=")                                                                                \
+    X(TOK_CARET,                  "^")                                                                                 \
+    X(TOK_CARET_EQUALS,           "^=")                                                                                \
+    X(TOK_TILDE,                  "~")                                                                                 \
+    X(TOK_LESS_LESS,              "<<")                                                                                \
+    X(TOK_LESS_LESS_EQUALS,       "<<=")                                                                               \
+    X(TOK_GREATER_GREATER,        ">>")                                                                                \
+    X(TOK_GREATER_GREATER_EQUALS, ">>=")                                                                               \
+    X(TOK_LEFT_PAREN,             "(")                                                                                 \
+    X(TOK_RIGHT_PAREN,            ")")                                                                                 \
+    X(TOK_LEFT_BRACE,             "{")                                                                                 \
+    X(TOK_RIGHT_BRACE,            "}")                                                                                 \
+    X(TOK_LEFT_BRACKET,           "[")                                                                                 \
+    X(TOK_RIGHT_BRACKET,          "]")                                                                                 \
+    X(TOK_COMMA,                  ",")                                                                                 \
+    X(TOK_DOT,                    ".")                                                                                 \
+    X(TOK_ELLIPSIS,               "...")                                                                               \
+    X(TOK_SEMICOLON,              ";")                                                                                 \
+    X(TOK_COLON,                  ":")                                                                                 \
+    X(TOK_COLON_COLON,            "::")                                                                                \
+    X(TOK_QUESTION_MARK,          "?")                                                                                 \
+    X(TOK_MINUS_GREATER,          "->")                                                                                \
+    X(TOK_AT,                     "@")
+
+// A range of bytes in the token's source file
+typedef struct {
+    u32 offset;
+    u32 len;
+} Span;
+
 typedef struct {
     TokenType type;
+    u32 offset; // Start of the token in its source, lines and columns are looked up from it when needed
     union {
-        String identifier;
-        String stringLiteral;
+        struct {
+            Span span;
+            Symbol symbol;
+        } identifier;
+        Symbol stringLiteral;
         u8 charLiteral;
         usize integerLiteral;
         f64 floatLiteral;
         u8 unknown;
-        String error;
+        cstr error;
     } as;
-    usize line;
-    usize col;
 } Token;
 
 typedef struct {
     LIST_FIELDS(Token);
 } TokensList;
 
+// Payload of the tokens that carry one, 8 bytes instead of the 16 byte Token union
+typedef union {
+    Symbol symbol;
+    u8 byte;
+    u64 integer;
+    f64 real;
+    cstr error;
+} TokenPayload;
+
+/**
+ * Struct of arrays token storage instead of sizeof(Token) per token: a 1 byte type and a 4 byte offset for every token,
+ * plus an 8 byte TokenPayload for the ones that carry a value.
+ * Only identifiers, literals, unknown characters and errors have an entry in `payloads`, in token order, so a token's
+ * payload is found by counting the payload carrying tokens before it.
+ */
+typedef struct {
+    u8 *types;
+    u32 *offsets;
+    usize len;
+    usize cap;
+    struct {
+        LIST_FIELDS(TokenPayload);
+    } payloads;
+    const SourceFile *source;
+} CompactTokensList;
+
+static inline Bool tokenHasPayload(TokenType type) {
+    return type == TOK_IDENTIFIER || type == TOK_STRING_LITERAL || type == TOK_CHAR_LITERAL ||
+           type == TOK_INTEGER_LITERAL || type == TOK_FLOAT_LITERAL || type == TOK_UNKNOWN || type == TOK_ERROR;
+}
+
 TokenType findKeywordOrIdent(String keyword);
-Token makeSimple(TokenType type, usize line, usize col);
-Token makeUnknown(u8 c, usize line, usize col);
-Token makeIdentifierToken(String ident, usize line, usize col);
-Token makeStringLiteralToken(String strLit, usize line, usize col);
-Token makeIntegerLiteralToken(u64 value, usize line, usize col);
-Token makeFloatLiteralToken(f64 value, usize line, usize col);
-Token makeCharLiteralToken(u8 value, usize line, usize col);
-Token makeErrorToken(String errorMsg, usize line, usize col);
-void printToken(Token token);
+Token makeSimple(TokenType type, u32 offset);
+Token makeUnknown(u8 c, u32 offset);
+Token makeIdentifierToken(Span ident, Symbol symbol);
+Token makeStringLiteralToken(Symbol strLit, u32 offset);
+Token makeIntegerLiteralToken(u64 value, u32 offset);
+Token makeFloatLiteralToken(f64 value, u32 offset);
+Token makeCharLiteralToken(u8 value, u32 offset);
+Token makeErrorToken(cstr errorMsg, u32 offset);
+// Move the token by `delta` bytes, after an edit earlier in its source
+void shiftToken(Token *token, i64 delta);
+String spanText(const SourceFile *source, Span span);
+void printToken(const SourceFile *source, Token token);
+
+void appendCompactToken(CompactTokensList *dest, Token token);
+// Rebuild the full token at `index`, `payloadIndex` is the number of payload carrying tokens before it
+Token compactToken(const CompactTokensList *tokens, usize index, usize payloadIndex);
+void freeCompactTokensList(CompactTokensList *tokens);
 
 #endif  // INCLUDE_KC_TOKEN_H_
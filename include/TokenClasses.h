@@ -0,0 +1,54 @@
+#ifndef INCLUDE_KC_TOKEN_CLASSES_H_
+#define INCLUDE_KC_TOKEN_CLASSES_H_
+
+#include "Token.h"
+
+/**
+ * The token classes the parser tests the next token against, as list macros for TOKEN_SET, see Token.h.
+ * TOKEN_CLASS_HAS(list, type) is a TokenSet bit test. Built with -DTOKEN_CLASS_VARIADIC it goes through the variadic
+ * match the parser used before TokenSet instead, which is how bench/parser.c times parse both ways.
+ */
+
+#define INCREMENT_OPS(X)      X(TOK_PLUS_PLUS) X(TOK_MINUS_MINUS)
+#define UNARY_OPS(X)          X(TOK_AMPERSAND) X(TOK_STAR) X(TOK_PLUS) X(TOK_MINUS) X(TOK_TILDE) X(TOK_BANG)
+#define MEMBER_OPS(X)         X(TOK_DOT) X(TOK_MINUS_GREATER)
+#define PRIMARY_TOKENS(X)                                                                                              \
+    X(TOK_INTEGER_LITERAL) X(TOK_FLOAT_LITERAL) X(TOK_CHAR_LITERAL) X(TOK_STRING_LITERAL) X(TOK_IDENTIFIER)
+#define STORAGE_CLASSES(X)    X(TOK_EXTERN) X(TOK_STATIC)
+#define TYPE_NAMES(X)                                                                                                  \
+    X(TOK_U8) X(TOK_U16) X(TOK_U32) X(TOK_U64) X(TOK_I8) X(TOK_I16) X(TOK_I32) X(TOK_I64) X(TOK_F32) X(TOK_F64)        \
+    X(TOK_BOOL) X(TOK_VOID) X(TOK_IDENTIFIER)
+#define DECLARATION_START(X)  X(TOK_CONST) STORAGE_CLASSES(X) TYPE_NAMES(X)
+
+// Every class above, for code that goes through all of them
+#define TOKEN_CLASSES(X)                                                                                               \
+    X(INCREMENT_OPS) X(UNARY_OPS) X(MEMBER_OPS) X(PRIMARY_TOKENS) X(STORAGE_CLASSES) X(TYPE_NAMES) X(DECLARATION_START)
+
+#ifdef TOKEN_CLASS_VARIADIC
+
+#include <stdarg.h>
+
+static inline Bool variadicTokenMatch(TokenType type, usize count, ...) {
+    va_list args;
+    va_start(args, count);
+    for (usize i = 0; i < count; i++) {
+        if (type == va_arg(args, TokenType)) {
+            va_end(args);
+            return TRUE;
+        }
+    }
+    va_end(args);
+    return FALSE;
+}
+
+#define TOKEN_CLASS_COUNT_(type) +1
+#define TOKEN_CLASS_ARG_(type)   , type
+#define TOKEN_CLASS_HAS(list, type) variadicTokenMatch((type), 0 list(TOKEN_CLASS_COUNT_) list(TOKEN_CLASS_ARG_))
+
+#else
+
+#define TOKEN_CLASS_HAS(list, type) tokenSetHas((TokenSet)TOKEN_SET(list), (type))
+
+#endif // TOKEN_CLASS_VARIADIC
+
+#endif // INCLUDE_KC_TOKEN_CLASSES_H_
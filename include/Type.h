@@ -23,8 +23,8 @@ struct Type {
     Bool isConst;
 };
 
-Type *makePrimitiveType(Token primitiveType, Bool isConst);
-Type *makePointerType(Type *pointerType, Bool isConst);
-Type *makeArrayType(Type *innerType, Expr *sizeExpr, Bool isConst);
+Type *makePrimitiveType(Arena *arena, Token primitiveType, Bool isConst);
+Type *makePointerType(Arena *arena, Type *pointerType, Bool isConst);
+Type *makeArrayType(Arena *arena, Type *innerType, Expr *sizeExpr, Bool isConst);
 
 #endif // INCLUDE_KC_TYPE_H_
@@ -0,0 +1,102 @@
+#ifndef INCLUDE_KC_WALK_H_
+#define INCLUDE_KC_WALK_H_
+
+#include <libk/Types.h>
+#include <stdlib.h>
+
+/**
+ * Explicit stack traversal of the AST.
+ * Generated code can nest expressions far deeper than the native stack allows, so passes that visit every node keep
+ * their position in a heap allocated stack instead of recursing.
+ * The visitor is called when the walk reaches a node (step 0), and again after each child it asked for has been
+ * walked (step 1, 2, ...). Every call either asks for one more child by filling in `child` and returning TRUE, or
+ * returns FALSE to finish the node. Children are walked in the order they are asked for, so a pass can skip some or
+ * pick them depending on what it has seen, like eval does with the branches of ?:.
+ */
+
+typedef enum {
+    WALK_EXPR,
+    WALK_TYPE,
+    WALK_FLAT, // A FlatNode, see FlatAst.h
+} WalkKind;
+
+typedef struct {
+    WalkKind kind;
+    const void *node;
+    usize data; // Belongs to the visitor, carried along with the node (print keeps the indentation here)
+} WalkNode;
+
+typedef Bool (*WalkVisitor)(void *ctx, WalkNode node, u32 step, WalkNode *child);
+
+// Double the capacity of a stack that starts out in `inlineArr`, moving it to the heap the first time
+void *walkGrowStack(void *arr, void *inlineArr, usize *cap, usize itemSize);
+
+// Enough for everything but machine generated code, deeper walks move the stack to the heap
+#define WALK_INLINE_FRAMES 64
+
+typedef struct {
+    WalkNode node;
+    u32 step;
+} WalkFrame;
+
+// Inline so each pass gets a copy with its visitor inlined into the loop, an indirect call per step costs as much as
+// the work most visitors do
+static inline void walk(WalkNode root, WalkVisitor visitor, void *ctx) {
+    WalkFrame inlineFrames[WALK_INLINE_FRAMES];
+    WalkFrame *frames = inlineFrames;
+    usize cap = WALK_INLINE_FRAMES;
+    usize len = 0;
+
+    frames[len++] = (WalkFrame){.node = root, .step = 0};
+    while (len > 0) {
+        WalkFrame *top = &frames[len - 1];
+        WalkNode child;
+        if (!visitor(ctx, top->node, top->step++, &child)) {
+            len--;
+            continue;
+        }
+
+        if (len == cap) frames = walkGrowStack(frames, inlineFrames, &cap, sizeof(WalkFrame));
+        frames[len++] = (WalkFrame){.node = child, .step = 0};
+    }
+
+    if (frames != inlineFrames) free(frames);
+}
+
+/**
+ * Stack of per node results for visitors that compute something bottom up: finishing a node pops its children's
+ * results and pushes its own. Lives on the native stack until it outgrows `inlineArr`.
+ */
+
+#define WALK_INLINE_RESULTS 64
+
+#define WALK_RESULTS(T)                                                                                                \
+    struct {                                                                                                           \
+        T *arr;                                                                                                        \
+        usize len;                                                                                                     \
+        usize cap;                                                                                                     \
+        T inlineArr[WALK_INLINE_RESULTS];                                                                              \
+    }
+
+#define WALK_RESULTS_INIT(results)                                                                                     \
+    do {                                                                                                               \
+        (results)->arr = (results)->inlineArr;                                                                         \
+        (results)->len = 0;                                                                                            \
+        (results)->cap = WALK_INLINE_RESULTS;                                                                          \
+    } while (0)
+
+#define WALK_RESULTS_PUSH(results, value)                                                                              \
+    do {                                                                                                               \
+        if ((results)->len == (results)->cap) {                                                                        \
+            (results)->arr = walkGrowStack((results)->arr, (results)->inlineArr, &(results)->cap,                      \
+                                           sizeof(*(results)->arr));                                                   \
+        }                                                                                                              \
+        (results)->arr[(results)->len++] = (value);                                                                    \
+    } while (0)
+
+#define WALK_RESULTS_FREE(results)                                                                                     \
+    do {                                                                                                               \
+        if ((results)->arr != (results)->inlineArr) free((results)->arr);                                              \
+    } while (0)
+
+#endif // INCLUDE_KC_WALK_H_
@@ -0,0 +1,103 @@
+#include "Arena.h"
+
+#include <stddef.h>
+#include <string.h>
+
+// Large enough that a typical translation unit needs a handful of blocks
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+struct ArenaBlock {
+    ArenaBlock *prev;
+    usize used;
+    usize cap;
+    _Alignas(max_align_t) u8 data[];
+};
+
+static cstr arenaTagNames[] = {
+#define X(tag, name) [tag] = name,
+    ARENA_TAG_LIST
+#undef X
+};
+
+static ArenaBlock *newBlock(Arena *arena, usize size) {
+    usize cap = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + cap);
+    if (block == NULL) exit(1);
+
+    block->prev = arena->head;
+    block->used = 0;
+    block->cap = cap;
+    arena->head = block;
+    arena->blockCount++;
+    arena->reserved += cap;
+    return block;
+}
+
+/**********************************************************************************************************************
+ * Public Arena API
+ *********************************************************************************************************************/
+
+void *arenaAlloc(Arena *arena, ArenaTag tag, usize size) {
+    size = (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+
+    ArenaBlock *block = arena->head;
+    if (block == NULL || block->cap - block->used < size) block = newBlock(arena, size);
+
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    arena->counts[tag]++;
+    arena->bytes[tag] += size;
+    return ptr;
+}
+
+void *arenaCopy(Arena *arena, ArenaTag tag, const void *src, usize size) {
+    if (size == 0) return NULL;
+
+    void *dest = arenaAlloc(arena, tag, size);
+    memcpy(dest, src, size);
+    return dest;
+}
+
+void freeArena(Arena *arena) {
+    ArenaBlock *block = arena->head;
+    while (block != NULL) {
+        ArenaBlock *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    *arena = (Arena){0};
+}
+
+void mergeArena(Arena *dest, Arena *src) {
+    if (src->head == NULL) return;
+
+    ArenaBlock *oldest = src->head;
+    while (oldest->prev != NULL) oldest = oldest->prev;
+    // Slot the blocks in behind the head, `dest` keeps bumping the block it is in
+    if (dest->head == NULL) {
+        dest->head = src->head;
+    } else {
+        oldest->prev = dest->head->prev;
+        dest->head->prev = src->head;
+    }
+
+    dest->blockCount += src->blockCount;
+    dest->reserved += src->reserved;
+    dest->used += src->used;
+    for (usize tag = 0; tag < ARENA_TAG_COUNT; tag++) {
+        dest->counts[tag] += src->counts[tag];
+        dest->bytes[tag] += src->bytes[tag];
+    }
+    *src = (Arena){0};
+}
+
+void printArenaStats(FILE *out, const Arena *arena) {
+    fprintf(out, "arena: %zu bytes used of %zu reserved in %zu blocks\n", arena->used, arena->reserved,
+            arena->blockCount);
+    for (usize tag = 0; tag < ARENA_TAG_COUNT; tag++) {
+        fprintf(out, "  %-4s %10zu allocations %12zu bytes\n", arenaTagNames[tag], arena->counts[tag],
+                arena->bytes[tag]);
+    }
+}
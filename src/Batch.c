@@ -0,0 +1,178 @@
+#include "Batch.h"
+
+#include <libk/Errors.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#define BATCH_VECTORIZED
+#endif
+
+// Runs `code` on rows [from, to) one at a time, `env` has room for every variable
+static void runRows(const Bytecode *code, const int *const *columns, int *env, usize from, usize to, int *out) {
+    for (usize row = from; row < to; row++) {
+        for (usize v = 0; v < code->variables.len; v++) env[v] = columns[v][row];
+        out[row] = runBytecode(code, env);
+    }
+}
+
+#ifdef BATCH_VECTORIZED
+// Rows per block, every register holds a block of values
+#define BATCH_ROWS 128
+#define BATCH_LANES 8
+#define BATCH_VECTORS (BATCH_ROWS / BATCH_LANES)
+
+// Eight ints, one AVX2 register or a pair of SSE2 ones
+typedef int IntVector __attribute__((vector_size(BATCH_LANES * sizeof(int))));
+
+#if defined(__x86_64__) && defined(__linux__)
+#define BATCH_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define BATCH_TARGETS
+#endif
+
+#define BATCH_REGISTER(regs, reg) ((regs) + (usize)(reg) * BATCH_VECTORS)
+
+#define BATCH_LOOP(expression)                                                                                         \
+    for (usize i = 0; i < BATCH_VECTORS; i++) d[i] = (expression);                                                     \
+    break
+
+// Runs `code` over the block already loaded into `regs`, FALSE if a ?: has to go different ways for different rows
+BATCH_TARGETS static Bool runBlock(const Bytecode *code, IntVector *regs, int *out) {
+    const Instruction *ip = code->code.arr;
+    for (;;) {
+        if (ip->op == OP_RETURN) {
+            memcpy(out, BATCH_REGISTER(regs, ip->a), BATCH_ROWS * sizeof(int));
+            return TRUE;
+        }
+        if (ip->op == OP_JUMP) {
+            ip = code->code.arr + ip->b;
+            continue;
+        }
+        if (ip->op == OP_JUMP_IF_FALSE) {
+            const IntVector *condition = BATCH_REGISTER(regs, ip->a);
+            IntVector anyFalse = {0};
+            IntVector allFalse = anyFalse - 1;
+            for (usize i = 0; i < BATCH_VECTORS; i++) {
+                anyFalse |= condition[i] == 0;
+                allFalse &= condition[i] == 0;
+            }
+            int any = 0, all = -1;
+            for (usize lane = 0; lane < BATCH_LANES; lane++) {
+                any |= anyFalse[lane];
+                all &= allFalse[lane];
+            }
+            if (!all && any) return FALSE;
+            ip = all ? code->code.arr + ip->b : ip + 1;
+            continue;
+        }
+
+        IntVector *d = BATCH_REGISTER(regs, ip->dest);
+        const IntVector *a = BATCH_REGISTER(regs, ip->a);
+        const IntVector *b = BATCH_REGISTER(regs, ip->b);
+        switch ((Opcode)ip->op) {
+            case OP_MOVE:
+                BATCH_LOOP(a[i]);
+            case OP_NEG:
+                BATCH_LOOP(-a[i]);
+            case OP_BIT_NOT:
+                BATCH_LOOP(~a[i]);
+            // Vector comparisons give -1 for true where the bytecode gives 1
+            case OP_NOT:
+                BATCH_LOOP(-(a[i] == 0));
+            case OP_OR:
+                BATCH_LOOP(-((a[i] != 0) | (b[i] != 0)));
+            case OP_AND:
+                BATCH_LOOP(-((a[i] != 0) & (b[i] != 0)));
+            case OP_EQUAL:
+                BATCH_LOOP(-(a[i] == b[i]));
+            case OP_NOT_EQUAL:
+                BATCH_LOOP(-(a[i] != b[i]));
+            case OP_LESS:
+                BATCH_LOOP(-(a[i] < b[i]));
+            case OP_LESS_EQUAL:
+                BATCH_LOOP(-(a[i] <= b[i]));
+            case OP_GREATER:
+                BATCH_LOOP(-(a[i] > b[i]));
+            case OP_GREATER_EQUAL:
+                BATCH_LOOP(-(a[i] >= b[i]));
+            case OP_ADD:
+                BATCH_LOOP(a[i] + b[i]);
+            case OP_SUB:
+                BATCH_LOOP(a[i] - b[i]);
+            case OP_MUL:
+                BATCH_LOOP(a[i] * b[i]);
+            case OP_DIV:
+                BATCH_LOOP(a[i] / b[i]);
+            case OP_MOD:
+                BATCH_LOOP(a[i] % b[i]);
+            case OP_BIT_AND:
+                BATCH_LOOP(a[i] & b[i]);
+            case OP_BIT_XOR:
+                BATCH_LOOP(a[i] ^ b[i]);
+            case OP_BIT_OR:
+                BATCH_LOOP(a[i] | b[i]);
+            // Counts outside 0..31 are undefined in C, mask them like the scalar x86 shifts the VM compiles to do,
+            // where AVX2 would give 0
+            case OP_SHL:
+                BATCH_LOOP(a[i] << (b[i] & 31));
+            case OP_SHR:
+                BATCH_LOOP(a[i] >> (b[i] & 31));
+            default:
+                UNREACHABLE("Unknown opcode");
+        }
+        ip++;
+    }
+}
+#endif
+
+/**********************************************************************************************************************
+ * Public Batch API
+ *********************************************************************************************************************/
+
+void runBytecodeBatch(const Bytecode *code, const int *const *columns, usize rows, int *out) {
+    int *env = malloc((code->variables.len + 1) * sizeof(int));
+    if (env == NULL) exit(1);
+    usize row = 0;
+
+#ifdef BATCH_VECTORIZED
+    if (rows >= BATCH_ROWS) {
+        usize size = code->registerCount * BATCH_VECTORS * sizeof(IntVector);
+        IntVector *regs = aligned_alloc(sizeof(IntVector), size);
+        if (regs == NULL) exit(1);
+        for (usize k = 0; k < code->constants.len; k++) {
+            IntVector *reg = BATCH_REGISTER(regs, k);
+            for (usize i = 0; i < BATCH_VECTORS; i++) reg[i] = (IntVector){0} + code->constants.arr[k];
+        }
+
+        for (; row + BATCH_ROWS <= rows; row += BATCH_ROWS) {
+            for (usize v = 0; v < code->variables.len; v++)
+                memcpy(BATCH_REGISTER(regs, code->constants.len + v), columns[v] + row, BATCH_ROWS * sizeof(int));
+            if (!runBlock(code, regs, out + row)) runRows(code, columns, env, row, row + BATCH_ROWS, out);
+        }
+        free(regs);
+    }
+#endif
+
+    runRows(code, columns, env, row, rows, out);
+    free(env);
+}
+
+Bool evalExprBatch(const Expr *root, const BatchColumn *columns, usize columnCount, usize rows, int *out) {
+    Bytecode code;
+    if (!compileExpr(&code, root)) return FALSE;
+
+    const int **bound = malloc((code.variables.len + 1) * sizeof(int *));
+    if (bound == NULL) exit(1);
+    Bool ok = TRUE;
+    for (usize v = 0; v < code.variables.len && ok; v++) {
+        bound[v] = NULL;
+        for (usize i = 0; i < columnCount && bound[v] == NULL; i++)
+            if (columns[i].name == code.variables.arr[v]) bound[v] = columns[i].values;
+        ok = bound[v] != NULL;
+    }
+    if (ok) runBytecodeBatch(&code, bound, rows, out);
+
+    free(bound);
+    freeBytecode(&code);
+    return ok;
+}
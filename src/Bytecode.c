@@ -0,0 +1,410 @@
+#include "Bytecode.h"
+
+#include <libk/Errors.h>
+#include <string.h>
+
+// While compiling, operands are tagged with the part of the register file they are in, whose sizes are only known at
+// the end. Untagged operands are temporaries.
+#define OPERAND_CONSTANT (1u << 30)
+#define OPERAND_VARIABLE (2u << 30)
+#define OPERAND_INDEX(operand) ((operand) & ~(3u << 30))
+
+// Fewer registers than this live on the native stack while running
+#define VM_INLINE_REGISTERS 64
+
+typedef struct {
+    Bytecode *code;
+    // Operand of every finished child, with the jumps a ?: still has to patch in between
+    WALK_RESULTS(u32) results;
+    u32 temps;    // Temporaries in use
+    u32 maxTemps; // Size of the temporaries' part of the register file
+    Bool failed;
+    // Open addressing map from a leaf to its tagged operand, so every constant value and variable gets one register.
+    // Keys are the operand tag in the high half and the int value or symbol in the low half, 0 marks an empty slot.
+    u64 *keys;
+    u32 *operands;
+    usize cap;
+    usize len;
+} Compiler;
+
+static void growLeaves(Compiler *c) {
+    u64 *oldKeys = c->keys;
+    u32 *oldOperands = c->operands;
+    usize oldCap = c->cap;
+
+    c->cap = oldCap == 0 ? 64 : oldCap * 2;
+    c->keys = calloc(c->cap, sizeof(u64));
+    c->operands = malloc(c->cap * sizeof(u32));
+    if (c->keys == NULL || c->operands == NULL) exit(1);
+    for (usize i = 0; i < oldCap; i++) {
+        if (oldKeys[i] == 0) continue;
+        usize slot = (oldKeys[i] * 0x9E3779B97F4A7C15ull) >> 32 & (c->cap - 1);
+        while (c->keys[slot] != 0) slot = (slot + 1) & (c->cap - 1);
+        c->keys[slot] = oldKeys[i];
+        c->operands[slot] = oldOperands[i];
+    }
+    free(oldKeys);
+    free(oldOperands);
+}
+
+// Operand of a constant or variable, added to the register file the first time it is seen
+static u32 leafOperand(Compiler *c, u32 tag, u32 value) {
+    if (2 * (c->len + 1) > c->cap) growLeaves(c);
+
+    u64 key = (u64)tag << 32 | value;
+    usize slot = (key * 0x9E3779B97F4A7C15ull) >> 32 & (c->cap - 1);
+    while (c->keys[slot] != 0) {
+        if (c->keys[slot] == key) return c->operands[slot];
+        slot = (slot + 1) & (c->cap - 1);
+    }
+
+    usize index = tag == OPERAND_CONSTANT ? c->code->constants.len : c->code->variables.len;
+    ILLEGAL(index >= OPERAND_CONSTANT, "Too many registers");
+    if (tag == OPERAND_CONSTANT)
+        appendSingle(&c->code->constants, (int)value);
+    else
+        appendSingle(&c->code->variables, value);
+
+    u32 operand = tag | (u32)index;
+    c->keys[slot] = key;
+    c->operands[slot] = operand;
+    c->len++;
+    return operand;
+}
+
+static u32 constantOperand(Compiler *c, int value) { return leafOperand(c, OPERAND_CONSTANT, (u32)value); }
+
+// Temporary `index`, which the caller has just taken into use
+static u32 tempOperand(Compiler *c, u32 index) {
+    ILLEGAL(index >= OPERAND_CONSTANT, "Too many registers");
+    if (index + 1 > c->maxTemps) c->maxTemps = index + 1;
+    return index;
+}
+
+static usize emit(Compiler *c, Opcode op, u32 dest, u32 a, u32 b) {
+    appendSingle(&c->code->code, ((Instruction){.op = op, .dest = dest, .a = a, .b = b}));
+    return c->code->code.len - 1;
+}
+
+static inline u32 popResult(Compiler *c) { return c->results.arr[--c->results.len]; }
+
+// Apply `op` to the node's two operands on top of the results, the result takes the place of the first
+static void finishBinary(Compiler *c, Opcode op, u32 start) {
+    u32 b = popResult(c);
+    u32 a = popResult(c);
+    c->temps = start + 1;
+    u32 dest = tempOperand(c, start);
+    emit(c, op, dest, a, b);
+    WALK_RESULTS_PUSH(&c->results, dest);
+}
+
+// Stand in for a node that can't be compiled, so its parent still finds an operand
+static Bool fail(Compiler *c) {
+    c->failed = TRUE;
+    WALK_RESULTS_PUSH(&c->results, constantOperand(c, 0));
+    return FALSE;
+}
+
+static Bool binaryOpcode(TokenType token, Opcode *op) {
+    switch (token) {
+#define X(opcode, tokenType, operator)                                                                                 \
+    case tokenType:                                                                                                    \
+        *op = opcode;                                                                                                  \
+        return TRUE;
+        BYTECODE_BINARY_LIST
+#undef X
+        default:
+            return FALSE;
+    }
+}
+
+// Ask the walk for `expr` next, its temporaries start above the ones in use now
+static Bool descend(Compiler *c, WalkNode *child, const Expr *expr) {
+    *child = (WalkNode){.kind = WALK_EXPR, .node = expr, .data = c->temps};
+    return TRUE;
+}
+
+/**********************************************************************************************************************
+ * Compilation
+ *********************************************************************************************************************/
+
+static Bool compileStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    Compiler *c = ctx;
+    const Expr *root = node.node;
+    // Temporaries in use when the node was reached, its own result goes in the next one
+    u32 start = (u32)node.data;
+    Opcode op;
+
+    switch (root->type) {
+        case EXPR_LITERAL: {
+            Token value = root->as.primary.value;
+            if (value.type == TOK_INTEGER_LITERAL)
+                WALK_RESULTS_PUSH(&c->results, constantOperand(c, value.as.integerLiteral));
+            else if (value.type == TOK_IDENTIFIER)
+                WALK_RESULTS_PUSH(&c->results, leafOperand(c, OPERAND_VARIABLE, value.as.identifier.symbol));
+            else
+                return fail(c);
+            return FALSE;
+        }
+        case EXPR_CONSTANT: {
+            WALK_RESULTS_PUSH(&c->results, constantOperand(c, constantToInt(root->as.constant.value)));
+            return FALSE;
+        }
+        case EXPR_GROUPING:
+            // The inner result is the node's result
+            return step == 0 && descend(c, child, root->as.grouping.inner);
+        case EXPR_BINARY:
+            // Assignments evaluate to the assigned value and the comma operator to its right side, nothing has side
+            // effects so the left side is never read
+            if (root->as.binary.op == TOK_EQUALS || root->as.binary.op == TOK_COMMA)
+                return step == 0 && descend(c, child, root->as.binary.rhs);
+            if (step < 2) return descend(c, child, exprChild(root, step));
+            if (!binaryOpcode(root->as.binary.op, &op)) {
+                c->results.len -= 2;
+                return fail(c);
+            }
+            finishBinary(c, op, start);
+            return FALSE;
+        case EXPR_UNARY: {
+            if (step == 0) return descend(c, child, root->as.unary.inner);
+            switch (root->as.unary.op) {
+                case TOK_PLUS:
+                    return FALSE;
+                case TOK_MINUS:
+                    op = OP_NEG;
+                    break;
+                case TOK_TILDE:
+                    op = OP_BIT_NOT;
+                    break;
+                case TOK_BANG:
+                    op = OP_NOT;
+                    break;
+                default:
+                    c->results.len--;
+                    return fail(c);
+            }
+            u32 a = popResult(c);
+            c->temps = start + 1;
+            u32 dest = tempOperand(c, start);
+            emit(c, op, dest, a, 0);
+            WALK_RESULTS_PUSH(&c->results, dest);
+            return FALSE;
+        }
+        case EXPR_CONDITIONAL: {
+            // Only the branch that is taken runs, both leave their value in the node's temporary
+            u32 dest = tempOperand(c, start);
+            if (step == 0) return descend(c, child, root->as.conditional.condition);
+            if (step == 1) {
+                usize jumpToElse = emit(c, OP_JUMP_IF_FALSE, 0, popResult(c), 0);
+                WALK_RESULTS_PUSH(&c->results, (u32)jumpToElse);
+                c->temps = start;
+                return descend(c, child, root->as.conditional.thenBranch);
+            }
+            u32 value = popResult(c);
+            usize jump = popResult(c);
+            if (value != dest) emit(c, OP_MOVE, dest, value, 0);
+            if (step == 2) {
+                WALK_RESULTS_PUSH(&c->results, (u32)emit(c, OP_JUMP, 0, 0, 0));
+                c->code->code.arr[jump].b = (u32)c->code->code.len;
+                c->temps = start;
+                return descend(c, child, root->as.conditional.elseBranch);
+            }
+            c->code->code.arr[jump].b = (u32)c->code->code.len;
+            c->temps = start + 1;
+            WALK_RESULTS_PUSH(&c->results, dest);
+            return FALSE;
+        }
+        case EXPR_COMPOUND_ASSIGN:
+            // The value a = a op b would assign
+            if (step < 2) return descend(c, child, exprChild(root, step));
+            if (!binaryOpcode(compoundAssignOperator(root->as.compoundAssign.op), &op)) {
+                c->results.len -= 2;
+                return fail(c);
+            }
+            finishBinary(c, op, start);
+            return FALSE;
+        case EXPR_INCREMENT:
+            // Postfix increments produce the old value
+            if (step == 0) return descend(c, child, root->as.increment.target);
+            if (!root->as.increment.isPrefix) return FALSE;
+            WALK_RESULTS_PUSH(&c->results, constantOperand(c, 1));
+            finishBinary(c, root->as.increment.op == TOK_PLUS_PLUS ? OP_ADD : OP_SUB, start);
+            return FALSE;
+        case EXPR_INDEX:
+        case EXPR_FUNC_CALL:
+        case EXPR_MEMBER:
+            return fail(c);
+    }
+    UNREACHABLE("Unknown expression type");
+}
+
+// Registers of the tagged operand, now that the constants and variables have been counted
+static u32 resolveOperand(const Bytecode *code, u32 operand) {
+    u32 index = OPERAND_INDEX(operand);
+    switch (operand & ~OPERAND_INDEX(operand)) {
+        case OPERAND_CONSTANT:
+            return index;
+        case OPERAND_VARIABLE:
+            return (u32)code->constants.len + index;
+        default:
+            return (u32)(code->constants.len + code->variables.len) + index;
+    }
+}
+
+/**********************************************************************************************************************
+ * Public Bytecode API
+ *********************************************************************************************************************/
+
+Bool compileExpr(Bytecode *code, const Expr *root) {
+    *code = (Bytecode){0};
+    Compiler c = {.code = code};
+    WALK_RESULTS_INIT(&c.results);
+    walk((WalkNode){.kind = WALK_EXPR, .node = root, .data = 0}, compileStep, &c);
+    emit(&c, OP_RETURN, 0, c.results.arr[0], 0);
+
+    WALK_RESULTS_FREE(&c.results);
+    free(c.keys);
+    free(c.operands);
+    if (c.failed) {
+        freeBytecode(code);
+        return FALSE;
+    }
+
+    for (usize i = 0; i < code->code.len; i++) {
+        Instruction *instr = &code->code.arr[i];
+        switch ((Opcode)instr->op) {
+            case OP_JUMP:
+                break;
+            case OP_RETURN:
+            case OP_JUMP_IF_FALSE:
+                instr->a = resolveOperand(code, instr->a);
+                break;
+            case OP_MOVE:
+            case OP_NEG:
+            case OP_BIT_NOT:
+            case OP_NOT:
+                instr->dest = resolveOperand(code, instr->dest);
+                instr->a = resolveOperand(code, instr->a);
+                break;
+            default:
+                instr->dest = resolveOperand(code, instr->dest);
+                instr->a = resolveOperand(code, instr->a);
+                instr->b = resolveOperand(code, instr->b);
+                break;
+        }
+    }
+    code->registerCount = code->constants.len + code->variables.len + c.maxTemps;
+    return TRUE;
+}
+
+i64 bytecodeVariable(const Bytecode *code, Symbol name) {
+    for (usize i = 0; i < code->variables.len; i++)
+        if (code->variables.arr[i] == name) return (i64)i;
+    return -1;
+}
+
+/**********************************************************************************************************************
+ * Running
+ * With GCC and clang every handler jumps straight to the next one through a table of label addresses, which predicts
+ * far better than the single indirect jump of a switch. Elsewhere it falls back to the switch.
+ *********************************************************************************************************************/
+
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO
+// Labels as values are a GNU extension
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+#define VM_CASE(op) label_##op
+#define VM_NEXT() goto *labels[(++ip)->op]
+#define VM_JUMP(target) goto *labels[(ip = code->code.arr + (target))->op]
+#else
+#define VM_CASE(op) case op
+#define VM_NEXT()                                                                                                      \
+    ip++;                                                                                                              \
+    goto dispatch
+#define VM_JUMP(target)                                                                                                \
+    ip = code->code.arr + (target);                                                                                    \
+    goto dispatch
+#endif
+
+int runBytecode(const Bytecode *code, const int *env) {
+    int inlineRegs[VM_INLINE_REGISTERS];
+    int *regs = inlineRegs;
+    if (code->registerCount > VM_INLINE_REGISTERS) {
+        regs = malloc(code->registerCount * sizeof(int));
+        if (regs == NULL) exit(1);
+    }
+    if (code->constants.len > 0) memcpy(regs, code->constants.arr, code->constants.len * sizeof(int));
+    if (code->variables.len > 0) memcpy(regs + code->constants.len, env, code->variables.len * sizeof(int));
+
+    const Instruction *ip = code->code.arr;
+    int result;
+#ifdef VM_COMPUTED_GOTO
+    static const void *const labels[OPCODE_COUNT] = {
+        [OP_RETURN] = &&label_OP_RETURN,
+        [OP_MOVE] = &&label_OP_MOVE,
+        [OP_JUMP] = &&label_OP_JUMP,
+        [OP_JUMP_IF_FALSE] = &&label_OP_JUMP_IF_FALSE,
+        [OP_NEG] = &&label_OP_NEG,
+        [OP_BIT_NOT] = &&label_OP_BIT_NOT,
+        [OP_NOT] = &&label_OP_NOT,
+#define X(opcode, token, operator) [opcode] = &&label_##opcode,
+        BYTECODE_BINARY_LIST
+#undef X
+    };
+    goto *labels[ip->op];
+#else
+dispatch:
+    switch ((Opcode)ip->op) {
+#endif
+    VM_CASE(OP_RETURN):
+        result = regs[ip->a];
+        goto done;
+    VM_CASE(OP_MOVE):
+        regs[ip->dest] = regs[ip->a];
+        VM_NEXT();
+    VM_CASE(OP_JUMP):
+        VM_JUMP(ip->b);
+    VM_CASE(OP_JUMP_IF_FALSE):
+        if (!regs[ip->a]) {
+            VM_JUMP(ip->b);
+        }
+        VM_NEXT();
+    VM_CASE(OP_NEG):
+        regs[ip->dest] = -regs[ip->a];
+        VM_NEXT();
+    VM_CASE(OP_BIT_NOT):
+        regs[ip->dest] = ~regs[ip->a];
+        VM_NEXT();
+    VM_CASE(OP_NOT):
+        regs[ip->dest] = !regs[ip->a];
+        VM_NEXT();
+#define X(opcode, token, operator)                                                                                     \
+    VM_CASE(opcode) : regs[ip->dest] = regs[ip->a] operator regs[ip->b];                                               \
+        VM_NEXT();
+        BYTECODE_BINARY_LIST
+#undef X
+#ifndef VM_COMPUTED_GOTO
+        default:
+            UNREACHABLE("Unknown opcode");
+    }
+#endif
+
+done:
+    if (regs != inlineRegs) free(regs);
+    return result;
+}
+
+#ifdef VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+
+void freeBytecode(Bytecode *code) {
+    free(code->code.arr);
+    free(code->constants.arr);
+    free(code->variables.arr);
+    *code = (Bytecode){0};
+}
@@ -0,0 +1,48 @@
+#include "Diagnostic.h"
+
+#include <stdlib.h>
+
+// Offset order, ties keep the order they were reported in
+static int compareDiagnostics(const void *a, const void *b) {
+    const Diagnostic *lhs = *(const Diagnostic *const *)a;
+    const Diagnostic *rhs = *(const Diagnostic *const *)b;
+    if (lhs->offset != rhs->offset) return lhs->offset < rhs->offset ? -1 : 1;
+    return lhs < rhs ? -1 : lhs > rhs;
+}
+
+/**********************************************************************************************************************
+ * Public Diagnostic API
+ *********************************************************************************************************************/
+
+Bool reportDiagnostic(Diagnostics *diagnostics, u32 offset, cstr message) {
+    if (diagnostics->limit != 0 && diagnostics->len >= diagnostics->limit) {
+        diagnostics->truncated = TRUE;
+        return FALSE;
+    }
+
+    appendSingle(diagnostics, ((Diagnostic){.offset = offset, .message = message}));
+    return diagnostics->limit == 0 || diagnostics->len < diagnostics->limit;
+}
+
+void printDiagnostics(FILE *out, const SourceFile *source, const Diagnostics *diagnostics) {
+    // Each pass reports in source order, but later passes report offsets before the ones of earlier passes. Printing
+    // through a stable sort keeps the output in source order and the line lookup moving forward.
+    if (diagnostics->len == 0) return;
+    const Diagnostic **sorted = malloc(diagnostics->len * sizeof(Diagnostic *));
+    if (sorted == NULL) exit(1);
+    for (usize i = 0; i < diagnostics->len; i++) sorted[i] = &diagnostics->arr[i];
+    qsort(sorted, diagnostics->len, sizeof(Diagnostic *), compareDiagnostics);
+
+    usize hint = 0;
+    for (usize i = 0; i < diagnostics->len; i++) {
+        SourceLocation location = locateOffsetFrom(source, sorted[i]->offset, &hint);
+        fprintf(out, "[%zu:%zu]: %s\n", location.line, location.col, sorted[i]->message);
+    }
+    free(sorted);
+    if (diagnostics->truncated) fprintf(out, "Too many errors, stopping after %zu\n", diagnostics->len);
+}
+
+void freeDiagnostics(Diagnostics *diagnostics) {
+    free(diagnostics->arr);
+    *diagnostics = (Diagnostics){0};
+}
@@ -0,0 +1,220 @@
+#include "Document.h"
+
+#include <string.h>
+
+typedef struct {
+    LIST_FIELDS(DocumentEntry);
+} EntryList;
+
+// Cache `start` and `firstToken` of the entries up to `index` from the lengths and token counts before them
+static void knowEntries(Document *doc, usize index) {
+    DocumentEntry *entries = doc->entries.arr;
+    for (usize i = doc->knownEntries; i <= index; i++) {
+        entries[i].start = i == 0 ? doc->leading : entries[i - 1].start + entries[i - 1].length;
+        entries[i].firstToken = i == 0 ? 0 : entries[i - 1].firstToken + entries[i - 1].tokenCount;
+    }
+    if (index >= doc->knownEntries) doc->knownEntries = index + 1;
+}
+
+// Last entry starting at or before `offset`, 0 if there is none. Caches no further than the first entry past it.
+static usize entryAt(Document *doc, u32 offset) {
+    while (doc->knownEntries < doc->entries.len &&
+           (doc->knownEntries == 0 || doc->entries.arr[doc->knownEntries - 1].start <= offset))
+        knowEntries(doc, doc->knownEntries);
+
+    usize lo = 0, hi = doc->knownEntries;
+    while (hi - lo > 1) {
+        usize mid = lo + (hi - lo) / 2;
+        if (doc->entries.arr[mid].start <= offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// Move the nodes, tokens and diagnostics of entry `index` to where the statement starts now
+static void moveEntry(Document *doc, usize index) {
+    knowEntries(doc, index);
+    DocumentEntry *entry = &doc->entries.arr[index];
+    i64 shift = (i64)entry->start - entry->base;
+    if (shift == 0) return;
+
+    if (entry->stmt != NULL) shiftStmt(entry->stmt, shift);
+    for (usize i = 0; i < entry->tokenCount; i++) shiftToken(&doc->tokens.arr[entry->firstToken + i], shift);
+    for (usize i = 0; i < entry->diagnostics.len; i++) entry->diagnostics.arr[i].offset += shift;
+    entry->base = entry->start;
+}
+
+// Bring the entries up to date after bytes [start, editEnd) of the text changed and everything after them moved by
+// `delta`. Statements are parsed off a fresh lexer from the one before the edit, until the parser is at the start of an
+// old statement past the edit: the text from there on is the same as before, and so are its tokens and statements.
+static ErrCode reparse(Document *doc, u32 start, u32 editEnd, i64 delta) {
+    DocumentEntry *old = doc->entries.arr;
+    usize count = doc->entries.len;
+    u32 textEnd = (u32)doc->source.contents.len;
+
+    // One statement of slack before the edit, so a token ending right where the edit starts gets relexed with its new
+    // lookahead, and a statement the edit runs into from behind gets reparsed
+    usize first = entryAt(doc, start > 0 ? start - 1 : 0);
+    if (first > 0) first--;
+    u32 windowStart = first == 0 ? 0 : old[first].start;
+    usize firstToken = first == 0 ? 0 : old[first].firstToken;
+
+    // Old entries [first, resume) get replaced, `resumeStart` is where entry `resume` starts in the old text
+    usize resume = first;
+    u32 resumeStart = count > 0 ? old[first].start : 0;
+    usize resumeToken = firstToken;
+    u32 windowEnd = textEnd;
+    EntryList entries = {0};
+    TokenStream stream;
+    if (!openTokenStreamAt(&stream, &doc->source, windowStart)) return ALLOC_ERR;
+    while (TRUE) {
+        Token next = peekToken(&stream, 0);
+        if (next.type == TOK_EOF) {
+            resume = count;
+            resumeToken = doc->tokens.len;
+            break;
+        }
+        if (next.offset >= editEnd) {
+            u32 oldOffset = (u32)(next.offset - delta);
+            while (resume < count && resumeStart < oldOffset) {
+                resumeStart += old[resume].length;
+                resumeToken += old[resume].tokenCount;
+                resume++;
+            }
+            if (resume < count && resumeStart == oldOffset) {
+                windowEnd = next.offset;
+                break;
+            }
+        }
+
+        Diagnostics diagnostics = {0};
+        Stmt *stmt = parseStatement(&doc->arena, &stream, &diagnostics);
+        appendSingle(&entries, ((DocumentEntry){.stmt = stmt, .diagnostics = diagnostics, .base = next.offset}));
+    }
+    closeTokenStream(&stream);
+
+    // Tokens of the new statements. NUL bytes lex as EOF tokens, the one the stream hands out past the end of the text
+    // isn't in what scanSource returns.
+    TokensList fresh = {0};
+    if (!openTokenStreamAt(&stream, &doc->source, windowStart)) return ALLOC_ERR;
+    while (TRUE) {
+        Token token = nextToken(&stream);
+        if (token.type == TOK_EOF && token.offset == textEnd) break;
+        if (token.offset >= windowEnd && resume < count) break;
+        appendSingle(&fresh, token);
+    }
+    closeTokenStream(&stream);
+
+    // Tokens go to the statement they follow. Ahead of the first one there can only be the tokens after a NUL byte that
+    // stopped the parser before it had anything, when there are no statements at all.
+    for (usize i = 0, e = 0; i < fresh.len; i++) {
+        while (e < entries.len && fresh.arr[i].offset >= entries.arr[e].base) e++;
+        if (e > 0) entries.arr[e - 1].tokenCount++;
+    }
+    for (usize i = 0; i < entries.len; i++) {
+        u32 next = i + 1 < entries.len ? entries.arr[i + 1].base : windowEnd;
+        entries.arr[i].length = next - entries.arr[i].base;
+    }
+    // After a statement the window starts at a token the edit doesn't reach, the first new statement starts there too
+    if (first == 0) doc->leading = entries.len > 0 ? entries.arr[0].base : windowEnd;
+
+    // Splice the new tokens in, the reused ones only move along
+    TokensList *tokens = &doc->tokens;
+    usize tokenCount = tokens->len - (resumeToken - firstToken) + fresh.len;
+    if (tokenCount > tokens->cap) {
+        usize cap = tokens->cap > 0 ? tokens->cap : 8;
+        while (cap < tokenCount) cap *= 2;
+        tokens->arr = realloc(tokens->arr, cap * sizeof(Token));
+        if (tokens->arr == NULL) exit(1);
+        tokens->cap = cap;
+    }
+    memmove(tokens->arr + firstToken + fresh.len, tokens->arr + resumeToken,
+            (tokens->len - resumeToken) * sizeof(Token));
+    if (fresh.len > 0) memcpy(tokens->arr + firstToken, fresh.arr, fresh.len * sizeof(Token));
+    tokens->len = tokenCount;
+    freeTokensList(&fresh);
+
+    // Same for the statements
+    for (usize i = first; i < resume; i++) freeDiagnostics(&old[i].diagnostics);
+    usize entryCount = count - (resume - first) + entries.len;
+    if (entryCount > doc->entries.cap) {
+        doc->entries.arr = realloc(doc->entries.arr, entryCount * sizeof(DocumentEntry));
+        if (doc->entries.arr == NULL) exit(1);
+        doc->entries.cap = entryCount;
+    }
+    memmove(doc->entries.arr + first + entries.len, doc->entries.arr + resume,
+            (count - resume) * sizeof(DocumentEntry));
+    if (entries.len > 0) memcpy(doc->entries.arr + first, entries.arr, entries.len * sizeof(DocumentEntry));
+    doc->entries.len = entryCount;
+    // Starts from the window on are worked out again when somebody needs them
+    if (doc->knownEntries > first) doc->knownEntries = first;
+    free(entries.arr);
+
+    return NO_ERR;
+}
+
+/**********************************************************************************************************************
+ * Public Document API
+ *********************************************************************************************************************/
+
+ErrCode openDocument(Document *doc, cstr path) {
+    if (doc == NULL) return NULLPTR_ERR;
+    *doc = (Document){0};
+
+    ErrCode err = openSourceFile(&doc->source, path);
+    if (err != NO_ERR) return err;
+    if (doc->source.contents.len > U32_MAX) return ALLOC_ERR;
+    // As if the whole text had just been typed into an empty document
+    return reparse(doc, 0, 0, 0);
+}
+
+ErrCode editDocument(Document *doc, u32 start, u32 end, String text) {
+    if (doc == NULL) return NULLPTR_ERR;
+    ILLEGAL(start > end || end > doc->source.contents.len, "Edit outside of the document");
+
+    ErrCode err = editSourceFile(&doc->source, start, end, text);
+    if (err != NO_ERR) return err;
+    return reparse(doc, start, start + text.len, (i64)text.len - (end - start));
+}
+
+Stmt *documentStatement(Document *doc, usize index) {
+    moveEntry(doc, index);
+    return doc->entries.arr[index].stmt;
+}
+
+StmtList documentStatements(Document *doc) {
+    doc->statements.len = 0;
+    for (usize i = 0; i < doc->entries.len; i++) {
+        Stmt *stmt = documentStatement(doc, i);
+        if (stmt != NULL) appendSingle(&doc->statements, stmt);
+    }
+    return doc->statements;
+}
+
+TokensList documentTokens(Document *doc) {
+    for (usize i = 0; i < doc->entries.len; i++) moveEntry(doc, i);
+    return doc->tokens;
+}
+
+Diagnostics documentDiagnostics(Document *doc) {
+    doc->diagnostics.len = 0;
+    for (usize i = 0; i < doc->entries.len; i++) {
+        moveEntry(doc, i);
+        const Diagnostics *diagnostics = &doc->entries.arr[i].diagnostics;
+        for (usize j = 0; j < diagnostics->len; j++) appendSingle(&doc->diagnostics, diagnostics->arr[j]);
+    }
+    return doc->diagnostics;
+}
+
+void closeDocument(Document *doc) {
+    for (usize i = 0; i < doc->entries.len; i++) freeDiagnostics(&doc->entries.arr[i].diagnostics);
+    free(doc->statements.arr);
+    free(doc->entries.arr);
+    freeDiagnostics(&doc->diagnostics);
+    freeTokensList(&doc->tokens);
+    freeArena(&doc->arena);
+    closeSourceFile(&doc->source);
+    *doc = (Document){0};
+}
@@ -1,23 +1,25 @@
 #include "Expression.h"
 
 #include <libk/Errors.h>
+#include <limits.h>
 
-Expr *makePrimaryExpr(Token value) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makePrimaryExpr(Arena *arena, Token value) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_LITERAL;
     e->as.primary.value = value;
+    e->as.primary.declaration = NO_DECLARATION;
     return e;
 }
 
-Expr *makeGroupingExpr(Expr *inner) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeGroupingExpr(Arena *arena, Expr *inner) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_GROUPING;
     e->as.grouping.inner = inner;
     return e;
 }
 
-Expr *makeBinaryExpr(TokenType op, Expr *lhs, Expr *rhs) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeBinaryExpr(Arena *arena, TokenType op, Expr *lhs, Expr *rhs) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_BINARY;
     e->as.binary.op = op;
     e->as.binary.lhs = lhs;
@@ -25,16 +27,16 @@ Expr *makeBinaryExpr(TokenType op, Expr *lhs, Expr *rhs) {
     return e;
 }
 
-Expr *makeUnaryExpr(TokenType op, Expr *inner) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeUnaryExpr(Arena *arena, TokenType op, Expr *inner) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_UNARY;
     e->as.unary.op = op;
     e->as.unary.inner = inner;
     return e;
 }
 
-Expr *makeConditionalExpr(Expr *condition, Expr *thenBranch, Expr *elseBranch) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeConditionalExpr(Arena *arena, Expr *condition, Expr *thenBranch, Expr *elseBranch) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_CONDITIONAL;
     e->as.conditional.condition = condition;
     e->as.conditional.thenBranch = thenBranch;
@@ -42,24 +44,24 @@ Expr *makeConditionalExpr(Expr *condition, Expr *thenBranch, Expr *elseBranch) {
     return e;
 }
 
-Expr *makeIndexExpr(Expr *name, Expr *index) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeIndexExpr(Arena *arena, Expr *name, Expr *index) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_INDEX;
     e->as.index.name = name;
     e->as.index.index = index;
     return e;
 }
 
-Expr *makeFuncCallExpr(Expr *name, ArgsList args) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeFuncCallExpr(Arena *arena, Expr *name, ArgsList args) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_FUNC_CALL;
     e->as.funcCall.callee = name;
     e->as.funcCall.args = args;
     return e;
 }
 
-Expr *makeMemberExpr(TokenType op, Expr *object, Token member) {
-    Expr *e = malloc(sizeof(Expr));
+Expr *makeMemberExpr(Arena *arena, TokenType op, Expr *object, Token member) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
     e->type = EXPR_MEMBER;
     e->as.member.op = op;
     e->as.member.object = object;
@@ -67,55 +69,155 @@ Expr *makeMemberExpr(TokenType op, Expr *object, Token member) {
     return e;
 }
 
+Expr *makeCompoundAssignExpr(Arena *arena, TokenType op, Expr *target, Expr *value) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
+    e->type = EXPR_COMPOUND_ASSIGN;
+    e->as.compoundAssign.op = op;
+    e->as.compoundAssign.target = target;
+    e->as.compoundAssign.value = value;
+    return e;
+}
+
+Expr *makeIncrementExpr(Arena *arena, Token op, Bool isPrefix, Expr *target) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
+    e->type = EXPR_INCREMENT;
+    e->as.increment.op = op.type;
+    e->as.increment.offset = op.offset;
+    e->as.increment.isPrefix = isPrefix;
+    e->as.increment.target = target;
+    return e;
+}
+
+Expr *makeConstantExpr(Arena *arena, Constant value, u32 offset) {
+    Expr *e = ARENA_NEW(arena, ARENA_EXPR, Expr);
+    e->type = EXPR_CONSTANT;
+    e->as.constant.value = value;
+    e->as.constant.offset = offset;
+    return e;
+}
+
+TokenType compoundAssignOperator(TokenType op) {
+    switch (op) {
+#define X(assignOp, binaryOp)                                                                                          \
+    case assignOp: return binaryOp;
+        COMPOUND_ASSIGNMENT_LIST
+#undef X
+        default: UNREACHABLE("Not a compound assignment");
+    }
+}
+
 #define EVAL_BINARY(TOK, op)                                                                                           \
     case TOK:                                                                                                          \
-        lhs = evalExpr(root->as.binary.lhs);                                                                           \
-        rhs = evalExpr(root->as.binary.rhs);                                                                           \
         return lhs op rhs
 
+int evalBinaryOperator(TokenType op, int lhs, int rhs) {
+    switch (op) {
+        EVAL_BINARY(TOK_PLUS, +);
+        EVAL_BINARY(TOK_MINUS, -);
+        EVAL_BINARY(TOK_STAR, *);
+        EVAL_BINARY(TOK_SLASH, /);
+        EVAL_BINARY(TOK_PERCENT, %);
+        EVAL_BINARY(TOK_AMPERSAND, &);
+        EVAL_BINARY(TOK_CARET, ^);
+        EVAL_BINARY(TOK_PIPE, |);
+        EVAL_BINARY(TOK_LESS_LESS, <<);
+        EVAL_BINARY(TOK_GREATER_GREATER, >>);
+        EVAL_BINARY(TOK_PIPE_PIPE, ||);
+        EVAL_BINARY(TOK_AMPERSAND_AMPERSAND, &&);
+        EVAL_BINARY(TOK_EQUALS_EQUALS, ==);
+        EVAL_BINARY(TOK_BANG_EQUALS, !=);
+        EVAL_BINARY(TOK_LESS, <);
+        EVAL_BINARY(TOK_LESS_EQUALS, <=);
+        EVAL_BINARY(TOK_GREATER, >);
+        EVAL_BINARY(TOK_GREATER_EQUALS, >=);
+        default:
+            TODO("Binary Operators");
+    }
+}
+
+/**********************************************************************************************************************
+ * Walking
+ * Everything below visits nodes through walk, so no pass recurses once per level of nesting.
+ *********************************************************************************************************************/
+
+static inline WalkNode exprNode(const Expr *expr, usize data) {
+    return (WalkNode){.kind = WALK_EXPR, .node = expr, .data = data};
+}
+
+// Ask the walk to visit `expr` next
+static inline Bool descend(WalkNode *child, const Expr *expr, usize data) {
+    *child = exprNode(expr, data);
+    return TRUE;
+}
+
+const Expr *exprChild(const Expr *expr, u32 i) {
+    switch (expr->type) {
+        case EXPR_LITERAL:
+            return NULL;
+        case EXPR_GROUPING:
+            return i == 0 ? expr->as.grouping.inner : NULL;
+        case EXPR_BINARY:
+            return i == 0 ? expr->as.binary.lhs : i == 1 ? expr->as.binary.rhs : NULL;
+        case EXPR_UNARY:
+            return i == 0 ? expr->as.unary.inner : NULL;
+        case EXPR_CONDITIONAL:
+            if (i == 0) return expr->as.conditional.condition;
+            return i == 1 ? expr->as.conditional.thenBranch : i == 2 ? expr->as.conditional.elseBranch : NULL;
+        case EXPR_INDEX:
+            return i == 0 ? expr->as.index.name : i == 1 ? expr->as.index.index : NULL;
+        case EXPR_FUNC_CALL:
+            if (i == 0) return expr->as.funcCall.callee;
+            return i <= expr->as.funcCall.args.len ? expr->as.funcCall.args.arr[i - 1] : NULL;
+        case EXPR_MEMBER:
+            return i == 0 ? expr->as.member.object : NULL;
+        case EXPR_COMPOUND_ASSIGN:
+            return i == 0 ? expr->as.compoundAssign.target : i == 1 ? expr->as.compoundAssign.value : NULL;
+        case EXPR_INCREMENT:
+            return i == 0 ? expr->as.increment.target : NULL;
+        case EXPR_CONSTANT:
+            return NULL;
+    }
+    UNREACHABLE("Unkown expression type");
+}
+
+/**********************************************************************************************************************
+ * Evaluation
+ *********************************************************************************************************************/
+
+typedef WALK_RESULTS(int) EvalResults;
+
 #define EVAL_UNARY(TOK, op)                                                                                            \
     case TOK:                                                                                                          \
-        return op evalExpr(root->as.unary.inner)
+        *value = op *value;                                                                                            \
+        return FALSE
 
-int evalExpr(Expr *root) {
-    int lhs, rhs;
+static Bool evalStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    EvalResults *values = ctx;
+    const Expr *root = node.node;
+    int *value, rhs;
 
     switch (root->type) {
         case EXPR_LITERAL:
             switch (root->as.primary.value.type) {
                 case TOK_INTEGER_LITERAL:
-                    return root->as.primary.value.as.integerLiteral;
+                    WALK_RESULTS_PUSH(values, root->as.primary.value.as.integerLiteral);
+                    return FALSE;
                 default:
                     TODO("Primary Expressions");
             }
         case EXPR_BINARY:
-            switch (root->as.binary.op) {
-                EVAL_BINARY(TOK_PLUS, +);
-                EVAL_BINARY(TOK_MINUS, -);
-                EVAL_BINARY(TOK_STAR, *);
-                EVAL_BINARY(TOK_SLASH, /);
-                EVAL_BINARY(TOK_PERCENT, %);
-                EVAL_BINARY(TOK_AMPERSAND, &);
-                EVAL_BINARY(TOK_CARET, ^);
-                EVAL_BINARY(TOK_PIPE, |);
-                EVAL_BINARY(TOK_LESS_LESS, <<);
-                EVAL_BINARY(TOK_GREATER_GREATER, >>);
-                EVAL_BINARY(TOK_PIPE_PIPE, ||);
-                EVAL_BINARY(TOK_AMPERSAND_AMPERSAND, &&);
-                EVAL_BINARY(TOK_EQUALS_EQUALS, ==);
-                EVAL_BINARY(TOK_BANG_EQUALS, !=);
-                EVAL_BINARY(TOK_LESS, <);
-                EVAL_BINARY(TOK_LESS_EQUALS, <=);
-                EVAL_BINARY(TOK_GREATER, >);
-                EVAL_BINARY(TOK_GREATER_EQUALS, >=);
-                case TOK_EQUALS:
-                    return evalExpr(root->as.binary.rhs);
-                default:
-                    TODO("Binary Operators");
-            }
+            // Assignments evaluate to the assigned value, the target is never read
+            if (root->as.binary.op == TOK_EQUALS) return step == 0 && descend(child, root->as.binary.rhs, 0);
+            if (step < 2) return descend(child, exprChild(root, step), 0);
+            rhs = values->arr[--values->len];
+            value = &values->arr[values->len - 1];
+            *value = evalBinaryOperator(root->as.binary.op, *value, rhs);
+            return FALSE;
         case EXPR_GROUPING:
-            return evalExpr(root->as.grouping.inner);
+            return step == 0 && descend(child, root->as.grouping.inner, 0);
         case EXPR_UNARY:
+            if (step == 0) return descend(child, root->as.unary.inner, 0);
+            value = &values->arr[values->len - 1];
             switch (root->as.unary.op) {
                 EVAL_UNARY(TOK_PLUS, +);
                 EVAL_UNARY(TOK_MINUS, -);
@@ -134,192 +236,332 @@ int evalExpr(Expr *root) {
                     abort();
             }
         case EXPR_CONDITIONAL:
-            return evalExpr(root->as.conditional.condition) ? evalExpr(root->as.conditional.thenBranch)
-                                                            : evalExpr(root->as.conditional.elseBranch);
+            // Only the branch that is taken gets evaluated
+            if (step == 0) return descend(child, root->as.conditional.condition, 0);
+            if (step == 1) {
+                Bool condition = values->arr[--values->len];
+                return descend(child, condition ? root->as.conditional.thenBranch : root->as.conditional.elseBranch, 0);
+            }
+            return FALSE;
         case EXPR_INDEX:
             UNIMPLEMENTED("Index Expressions");
         case EXPR_FUNC_CALL:
             UNIMPLEMENTED("Function Call Expressions");
         case EXPR_MEMBER:
             UNIMPLEMENTED("Member Expressions");
+        case EXPR_COMPOUND_ASSIGN:
+            // The value a = a op b would assign
+            if (step < 2) return descend(child, exprChild(root, step), 0);
+            rhs = values->arr[--values->len];
+            value = &values->arr[values->len - 1];
+            *value = evalBinaryOperator(compoundAssignOperator(root->as.compoundAssign.op), *value, rhs);
+            return FALSE;
+        case EXPR_INCREMENT:
+            if (step == 0) return descend(child, root->as.increment.target, 0);
+            if (!root->as.increment.isPrefix) return FALSE;
+            value = &values->arr[values->len - 1];
+            *value += root->as.increment.op == TOK_PLUS_PLUS ? 1 : -1;
+            return FALSE;
+        case EXPR_CONSTANT: {
+            WALK_RESULTS_PUSH(values, constantToInt(root->as.constant.value));
+            return FALSE;
+        }
     }
     printf("Unknown expression type: %d\n", root->type);
     UNIMPLEMENTED("Don't come here");
 }
 
-Expr *cloneExpr(Expr *src) {
-    if (src == NULL) return NULL;
+int evalExpr(Expr *root) {
+    EvalResults values;
+    WALK_RESULTS_INIT(&values);
+    walk(exprNode(root, 0), evalStep, &values);
+
+    int result = values.arr[0];
+    WALK_RESULTS_FREE(&values);
+    return result;
+}
+
+/**********************************************************************************************************************
+ * Cloning
+ *********************************************************************************************************************/
 
+typedef struct {
+    Arena *arena;
+    WALK_RESULTS(Expr *) results;
+} CloneState;
+
+static Bool cloneStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    CloneState *state = ctx;
+    Arena *arena = state->arena;
+    const Expr *src = node.node;
+
+    const Expr *next = exprChild(src, step);
+    if (next != NULL) return descend(child, next, 0);
+
+    // Every child has been cloned, their copies are the top `step` results
+    state->results.len -= step;
+    Expr **kids = state->results.arr + state->results.len;
+    Expr *clone = NULL;
     switch (src->type) {
         case EXPR_LITERAL:
-            return makePrimaryExpr(src->as.primary.value);
+            clone = makePrimaryExpr(arena, src->as.primary.value);
+            clone->as.primary.declaration = src->as.primary.declaration;
+            break;
         case EXPR_GROUPING:
-            return makeGroupingExpr(cloneExpr(src->as.grouping.inner));
+            clone = makeGroupingExpr(arena, kids[0]);
+            break;
         case EXPR_BINARY:
-            return makeBinaryExpr(src->as.binary.op, cloneExpr(src->as.binary.lhs), cloneExpr(src->as.binary.rhs));
+            clone = makeBinaryExpr(arena, src->as.binary.op, kids[0], kids[1]);
+            break;
         case EXPR_UNARY:
-            return makeUnaryExpr(src->as.unary.op, cloneExpr(src->as.unary.inner));
+            clone = makeUnaryExpr(arena, src->as.unary.op, kids[0]);
+            break;
         case EXPR_CONDITIONAL:
-            return makeConditionalExpr(cloneExpr(src->as.conditional.condition),
-                                       cloneExpr(src->as.conditional.thenBranch),
-                                       cloneExpr(src->as.conditional.elseBranch));
+            clone = makeConditionalExpr(arena, kids[0], kids[1], kids[2]);
+            break;
         case EXPR_INDEX:
-            return makeIndexExpr(cloneExpr(src->as.index.name), cloneExpr(src->as.index.index));
+            clone = makeIndexExpr(arena, kids[0], kids[1]);
+            break;
         case EXPR_FUNC_CALL: {
-            ArgsList args = {0};
-            for (usize i = 0; i < src->as.funcCall.args.len; i++) {
-                appendSingle(&args, cloneExpr(src->as.funcCall.args.arr[i]));
-            }
-            return makeFuncCallExpr(cloneExpr(src->as.funcCall.callee), args);
+            ArgsList args = {.len = src->as.funcCall.args.len, .cap = src->as.funcCall.args.len};
+            args.arr = arenaCopy(arena, ARENA_LIST, kids + 1, args.len * sizeof(Expr *));
+            clone = makeFuncCallExpr(arena, kids[0], args);
+            break;
         }
         case EXPR_MEMBER:
-            return makeMemberExpr(src->as.member.op, cloneExpr(src->as.member.object), src->as.member.member);
+            clone = makeMemberExpr(arena, src->as.member.op, kids[0], src->as.member.member);
+            break;
+        case EXPR_COMPOUND_ASSIGN:
+            clone = makeCompoundAssignExpr(arena, src->as.compoundAssign.op, kids[0], kids[1]);
+            break;
+        case EXPR_INCREMENT: {
+            Token op = {.type = src->as.increment.op, .offset = src->as.increment.offset};
+            clone = makeIncrementExpr(arena, op, src->as.increment.isPrefix, kids[0]);
+            break;
+        }
+        case EXPR_CONSTANT:
+            clone = makeConstantExpr(arena, src->as.constant.value, src->as.constant.offset);
+            break;
     }
-    UNREACHABLE("Unkown expression type");
+    WALK_RESULTS_PUSH(&state->results, clone);
+    return FALSE;
+}
+
+Expr *cloneExpr(Arena *arena, Expr *src) {
+    if (src == NULL) return NULL;
+
+    CloneState state = {.arena = arena};
+    WALK_RESULTS_INIT(&state.results);
+    walk(exprNode(src, 0), cloneStep, &state);
+
+    Expr *clone = state.results.arr[0];
+    WALK_RESULTS_FREE(&state.results);
+    return clone;
 }
 
+/**********************************************************************************************************************
+ * Relocation
+ *********************************************************************************************************************/
+
+static Bool shiftStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    i64 delta = *(i64 *)ctx;
+    // Walks hand out const nodes, relocation owns the tree it updates
+    Expr *root = (Expr *)node.node;
+
+    if (step == 0) {
+        switch (root->type) {
+            case EXPR_LITERAL:
+                shiftToken(&root->as.primary.value, delta);
+                break;
+            case EXPR_MEMBER:
+                shiftToken(&root->as.member.member, delta);
+                break;
+            case EXPR_INCREMENT:
+                root->as.increment.offset += delta;
+                break;
+            case EXPR_CONSTANT:
+                root->as.constant.offset += delta;
+                break;
+            default:
+                break;
+        }
+    }
+
+    const Expr *next = exprChild(root, step);
+    return next != NULL && descend(child, next, 0);
+}
+
+void shiftExpr(Expr *root, i64 delta) {
+    if (root == NULL) return;
+    walk(exprNode(root, 0), shiftStep, &delta);
+}
+
+/**********************************************************************************************************************
+ * Printing
+ *********************************************************************************************************************/
+
 static void printIndent(int indent) {
     for (int i = 0; i < indent; i++) printf("  ");
 }
 
-void printExprImpl(Expr *root, usize indent) {
-    printf("{\n");
+// Start a field whose value is printed by walking into it
+static Bool printField(WalkNode *child, cstr name, const Expr *expr, usize indent) {
+    printIndent(indent);
+    printf("\"%s\": ", name);
+    return descend(child, expr, indent);
+}
+
+static Bool printClose(usize indent) {
+    printIndent(indent);
+    printf("}\n");
+    return FALSE;
+}
+
+Bool printExprStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    const SourceFile *source = ctx;
+    const Expr *root = node.node;
+    usize indent = node.data;
+
+    if (step == 0) {
+        printf("{\n");
+        printIndent(indent + 1);
+        switch (root->type) {
+            case EXPR_LITERAL:
+                printf("\"type\": \"literal\",\n");
+                printIndent(indent + 1);
+                printf("\"token\": ");
+                printToken(source, root->as.primary.value);
+                printf("\n");
+                return printClose(indent);
+            case EXPR_GROUPING:
+                printf("\"type\": \"grouping\",\n");
+                return printField(child, "inner", root->as.grouping.inner, indent + 1);
+            case EXPR_BINARY:
+                printf("\"type\": \"binary\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.binary.op]);
+                return printField(child, "lhs", root->as.binary.lhs, indent + 1);
+            case EXPR_UNARY:
+                printf("\"type\": \"unary\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.unary.op]);
+                return printField(child, "inner", root->as.unary.inner, indent + 1);
+            case EXPR_CONDITIONAL:
+                printf("\"type\": \"conditional\",\n");
+                return printField(child, "condition", root->as.conditional.condition, indent + 1);
+            case EXPR_INDEX:
+                printf("\"type\": \"index\",\n");
+                return printField(child, "name", root->as.index.name, indent + 1);
+            case EXPR_FUNC_CALL:
+                printf("\"type\": \"func_call\",\n");
+                return printField(child, "callee", root->as.funcCall.callee, indent + 1);
+            case EXPR_MEMBER:
+                printf("\"type\": \"member\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.member.op]);
+                return printField(child, "object", root->as.member.object, indent + 1);
+            case EXPR_COMPOUND_ASSIGN:
+                printf("\"type\": \"compound_assign\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.compoundAssign.op]);
+                return printField(child, "target", root->as.compoundAssign.target, indent + 1);
+            case EXPR_INCREMENT:
+                printf("\"type\": \"increment\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.increment.op]);
+                printIndent(indent + 1);
+                printf("\"prefix\": %s,\n", root->as.increment.isPrefix ? "true" : "false");
+                return printField(child, "target", root->as.increment.target, indent + 1);
+            case EXPR_CONSTANT:
+                printf("\"type\": \"constant\",\n");
+                printIndent(indent + 1);
+                printf("\"value\": ");
+                printConstant(source, root->as.constant.value, root->as.constant.offset);
+                printf("\n");
+                return printClose(indent);
+        }
+    }
+
+    // Back from child `step - 1`
     switch (root->type) {
-        case EXPR_LITERAL:
-            printIndent(indent + 1);
-            printf("\"type\": \"literal\",\n");
-            printIndent(indent + 1);
-            printf("\"token\": ");
-            printToken(root->as.primary.value);
-            printf("\n");
-            break;
-        case EXPR_GROUPING:
-            printIndent(indent + 1);
-            printf("\"type\": \"grouping\",\n");
-            printIndent(indent + 1);
-            printf("\"inner\": ");
-            printExprImpl(root->as.grouping.inner, indent + 1);
-            break;
         case EXPR_BINARY:
-            printIndent(indent + 1);
-            printf("\"type\": \"binary\",\n");
-            printIndent(indent + 1);
-            printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.binary.op]);
-            printIndent(indent + 1);
-            printf("\"lhs\": ");
-            printExprImpl(root->as.binary.lhs, indent + 1);
-            printIndent(indent + 1);
-            printf("\"rhs\": ");
-            printExprImpl(root->as.binary.rhs, indent + 1);
-            break;
-        case EXPR_UNARY:
-            printIndent(indent + 1);
-            printf("\"type\": \"unary\",\n");
-            printIndent(indent + 1);
-            printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.unary.op]);
-            printIndent(indent + 1);
-            printf("\"inner\": ");
-            printExprImpl(root->as.unary.inner, indent + 1);
+            if (step == 1) return printField(child, "rhs", root->as.binary.rhs, indent + 1);
             break;
         case EXPR_CONDITIONAL:
-            printIndent(indent + 1);
-            printf("\"type\": \"conditional\",\n");
-            printIndent(indent + 1);
-            printf("\"condition\": ");
-            printExprImpl(root->as.conditional.condition, indent + 1);
-            printIndent(indent + 1);
-            printf("\"then\": ");
-            printExprImpl(root->as.conditional.thenBranch, indent + 1);
-            printIndent(indent + 1);
-            printf("\"else\": ");
-            printExprImpl(root->as.conditional.elseBranch, indent + 1);
+            if (step == 1) return printField(child, "then", root->as.conditional.thenBranch, indent + 1);
+            if (step == 2) return printField(child, "else", root->as.conditional.elseBranch, indent + 1);
             break;
         case EXPR_INDEX:
-            printIndent(indent + 1);
-            printf("\"type\": \"index\",\n");
-            printIndent(indent + 1);
-            printf("\"name\": ");
-            printExprImpl(root->as.index.name, indent + 1);
-            printIndent(indent + 1);
-            printf("\"index\": ");
-            printExprImpl(root->as.index.index, indent + 1);
+            if (step == 1) return printField(child, "index", root->as.index.index, indent + 1);
             break;
-        case EXPR_FUNC_CALL:
-            printIndent(indent + 1);
-            printf("\"type\": \"func_call\",\n");
-            printIndent(indent + 1);
-            printf("\"callee\": ");
-            printExprImpl(root->as.funcCall.callee, indent + 1);
-            printIndent(indent + 1);
-            printf("\"args\": [\n");
-            for (usize i = 0; i < root->as.funcCall.args.len; i++) {
+        case EXPR_FUNC_CALL: {
+            const ArgsList *args = &root->as.funcCall.args;
+            if (step == 1) {
+                printIndent(indent + 1);
+                printf("\"args\": [\n");
+            }
+            if (step <= args->len) {
                 printIndent(indent + 2);
-                printExprImpl(root->as.funcCall.args.arr[i], indent + 2);
+                return descend(child, args->arr[step - 1], indent + 2);
             }
             printIndent(indent + 1);
             printf("]\n");
             break;
+        }
         case EXPR_MEMBER:
-            printIndent(indent + 1);
-            printf("\"type\": \"member\",\n");
-            printIndent(indent + 1);
-            printf("\"op\": \"%s\",\n", tokenTypesStrings[root->as.member.op]);
-            printIndent(indent + 1);
-            printf("\"object\": ");
-            printExprImpl(root->as.member.object, indent + 1);
             printIndent(indent + 1);
             printf("\"member\": ");
-            printToken(root->as.member.member);
+            printToken(source, root->as.member.member);
             printf("\n");
             break;
+        case EXPR_COMPOUND_ASSIGN:
+            if (step == 1) return printField(child, "value", root->as.compoundAssign.value, indent + 1);
+            break;
+        default:
+            break;
     }
-    printIndent(indent);
-    printf("}\n");
+    return printClose(indent);
 }
 
-void printExpr(Expr *root) {
-    if (root == NULL) {
-        printf("null\n");
-        return;
+void printConstant(const SourceFile *source, Constant value, u32 offset) {
+    SourceLocation location = locateOffset(source, offset);
+    printf("{ [%zu:%zu] \"type\": \"%s\", ", location.line, location.col, tokenTypesStrings[value.type]);
+    switch (value.type) {
+        case TOK_F32:
+        case TOK_F64:
+            printf("\"value\": %.17g", value.as.real);
+            break;
+        case TOK_I8:
+        case TOK_I16:
+        case TOK_I32:
+        case TOK_I64:
+            printf("\"value\": %lld", (long long)value.as.integer);
+            break;
+        default:
+            printf("\"value\": %llu", (unsigned long long)value.as.integer);
+            break;
     }
+    printf(" }");
+}
 
-    printExprImpl(root, 0);
+int constantToInt(Constant value) {
+    if (value.type != TOK_F32 && value.type != TOK_F64) return (int)value.as.integer;
+    // Converting a real outside the range of int is undefined
+    if (value.as.real != value.as.real) return 0;
+    if (value.as.real >= (f64)INT_MAX) return INT_MAX;
+    if (value.as.real <= (f64)INT_MIN) return INT_MIN;
+    return (int)value.as.real;
 }
 
-void freeExpr(Expr *e) {
-    if (e == NULL) return;
+void printExprImpl(const SourceFile *source, Expr *root, usize indent) {
+    walk(exprNode(root, indent), printExprStep, (void *)source);
+}
 
-    switch (e->type) {
-        case EXPR_BINARY:
-            freeExpr(e->as.binary.lhs);
-            freeExpr(e->as.binary.rhs);
-            break;
-        case EXPR_UNARY:
-            freeExpr(e->as.unary.inner);
-            break;
-        case EXPR_LITERAL:
-            break;
-        case EXPR_GROUPING:
-            freeExpr(e->as.grouping.inner);
-            break;
-        case EXPR_CONDITIONAL:
-            freeExpr(e->as.conditional.condition);
-            freeExpr(e->as.conditional.thenBranch);
-            freeExpr(e->as.conditional.elseBranch);
-            break;
-        case EXPR_INDEX:
-            freeExpr(e->as.index.index);
-            freeExpr(e->as.index.name);
-            break;
-        case EXPR_FUNC_CALL:
-            freeExpr(e->as.funcCall.callee);
-            for (usize i = 0; i < e->as.funcCall.args.len; i++) {
-                freeExpr(e->as.funcCall.args.arr[i]);
-            }
-            break;
-        case EXPR_MEMBER:
-            freeExpr(e->as.member.object);
-            break;
+void printExpr(const SourceFile *source, Expr *root) {
+    if (root == NULL) {
+        printf("null\n");
+        return;
     }
-    free(e);
+
+    printExprImpl(source, root, 0);
 }
@@ -0,0 +1,393 @@
+#include "FlatAst.h"
+
+#include <libk/Errors.h>
+#include <stdio.h>
+#include <string.h>
+
+static FlatRef addNode(FlatAst *ast, FlatNode node) {
+    ILLEGAL(ast->nodes.len >= FLAT_NONE, "Flat AST out of indices");
+    appendSingle(&ast->nodes, node);
+    return (FlatRef)(ast->nodes.len - 1);
+}
+
+static u32 addToken(FlatAst *ast, Token token) {
+    appendSingle(&ast->tokens, token);
+    return (u32)(ast->tokens.len - 1);
+}
+
+static const FlatNode *node(const FlatAst *ast, FlatRef ref) { return &ast->nodes.arr[ref]; }
+
+static Constant flatConstant(const FlatNode *flat) {
+    Constant constant = {.type = flat->op};
+    u64 bits = (u64)flat->c << 32 | flat->b;
+    memcpy(&constant.as, &bits, sizeof(bits));
+    return constant;
+}
+
+static inline WalkNode flatNode(const FlatAst *ast, FlatRef ref, usize data) {
+    return (WalkNode){.kind = WALK_FLAT, .node = node(ast, ref), .data = data};
+}
+
+// Ask the walk to visit node `ref` next
+static inline Bool descend(WalkNode *child, const FlatAst *ast, FlatRef ref, usize data) {
+    *child = flatNode(ast, ref, data);
+    return TRUE;
+}
+
+/**********************************************************************************************************************
+ * Flattening
+ *********************************************************************************************************************/
+
+typedef struct {
+    FlatAst *ast;
+    WALK_RESULTS(FlatRef) refs;
+} Flattener;
+
+// Walks the pointer based tree, every finished node leaves its index on `refs` for its parent to pop
+static Bool flattenStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    Flattener *flattener = ctx;
+    FlatAst *ast = flattener->ast;
+    const Expr *root = node.node;
+
+    const Expr *next = exprChild(root, step);
+    if (next != NULL) {
+        *child = (WalkNode){.kind = WALK_EXPR, .node = next};
+        return TRUE;
+    }
+
+    flattener->refs.len -= step;
+    const FlatRef *refs = flattener->refs.arr + flattener->refs.len;
+    FlatNode flat = {.type = root->type};
+    switch (root->type) {
+        case EXPR_LITERAL:
+            flat.a = addToken(ast, root->as.primary.value);
+            break;
+        case EXPR_GROUPING:
+            flat.a = refs[0];
+            break;
+        case EXPR_BINARY:
+            flat.op = root->as.binary.op;
+            flat.a = refs[0];
+            flat.b = refs[1];
+            break;
+        case EXPR_UNARY:
+            flat.op = root->as.unary.op;
+            flat.a = refs[0];
+            break;
+        case EXPR_CONDITIONAL:
+            flat.a = refs[0];
+            flat.b = refs[1];
+            flat.c = refs[2];
+            break;
+        case EXPR_INDEX:
+            flat.a = refs[0];
+            flat.b = refs[1];
+            break;
+        case EXPR_FUNC_CALL:
+            // Nested calls appended their own arguments while ours were flattened, so ours are added in one go now
+            flat.a = refs[0];
+            flat.b = (u32)ast->args.len;
+            flat.c = step - 1;
+            for (u32 i = 1; i < step; i++) appendSingle(&ast->args, refs[i]);
+            break;
+        case EXPR_MEMBER:
+            flat.op = root->as.member.op;
+            flat.a = refs[0];
+            flat.b = addToken(ast, root->as.member.member);
+            break;
+        case EXPR_COMPOUND_ASSIGN:
+            flat.op = root->as.compoundAssign.op;
+            flat.a = refs[0];
+            flat.b = refs[1];
+            break;
+        case EXPR_INCREMENT:
+            flat.op = root->as.increment.op;
+            flat.a = refs[0];
+            flat.b = root->as.increment.isPrefix;
+            flat.c = root->as.increment.offset;
+            break;
+        case EXPR_CONSTANT: {
+            u64 bits;
+            memcpy(&bits, &root->as.constant.value.as, sizeof(bits));
+            flat.op = root->as.constant.value.type;
+            flat.a = root->as.constant.offset;
+            flat.b = (u32)bits;
+            flat.c = (u32)(bits >> 32);
+            break;
+        }
+    }
+    WALK_RESULTS_PUSH(&flattener->refs, addNode(ast, flat));
+    return FALSE;
+}
+
+/**********************************************************************************************************************
+ * Evaluation
+ *********************************************************************************************************************/
+
+typedef struct {
+    const FlatAst *ast;
+    WALK_RESULTS(int) values;
+} FlatEvaluator;
+
+#define EVAL_UNARY(TOK, op)                                                                                            \
+    case TOK:                                                                                                          \
+        *value = op *value;                                                                                            \
+        return FALSE
+
+static Bool evalFlatStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    FlatEvaluator *evaluator = ctx;
+    const FlatAst *ast = evaluator->ast;
+    const FlatNode *root = node.node;
+    int *value, rhs;
+
+    switch ((ExprType)root->type) {
+        case EXPR_LITERAL: {
+            const Token *token = &ast->tokens.arr[root->a];
+            switch (token->type) {
+                case TOK_INTEGER_LITERAL:
+                    WALK_RESULTS_PUSH(&evaluator->values, token->as.integerLiteral);
+                    return FALSE;
+                default:
+                    TODO("Primary Expressions");
+            }
+        }
+        case EXPR_BINARY:
+            // Assignments evaluate to the assigned value, the target is never read
+            if (root->op == TOK_EQUALS) return step == 0 && descend(child, ast, root->b, 0);
+            if (step < 2) return descend(child, ast, step == 0 ? root->a : root->b, 0);
+            rhs = evaluator->values.arr[--evaluator->values.len];
+            value = &evaluator->values.arr[evaluator->values.len - 1];
+            *value = evalBinaryOperator(root->op, *value, rhs);
+            return FALSE;
+        case EXPR_GROUPING:
+            return step == 0 && descend(child, ast, root->a, 0);
+        case EXPR_UNARY:
+            if (step == 0) return descend(child, ast, root->a, 0);
+            value = &evaluator->values.arr[evaluator->values.len - 1];
+            switch ((TokenType)root->op) {
+                EVAL_UNARY(TOK_PLUS, +);
+                EVAL_UNARY(TOK_MINUS, -);
+                EVAL_UNARY(TOK_TILDE, ~);
+                EVAL_UNARY(TOK_BANG, !);
+                case TOK_PLUS_PLUS:
+                    UNIMPLEMENTED("++");
+                case TOK_MINUS_MINUS:
+                    UNIMPLEMENTED("--");
+                case TOK_AMPERSAND:
+                    UNIMPLEMENTED("Unary Ampersand");
+                case TOK_STAR:
+                    UNIMPLEMENTED("Unary Star");
+                default:
+                    fprintf(stderr, "Not a valid unary operator: %d(%c)", root->op, root->op);
+                    abort();
+            }
+        case EXPR_CONDITIONAL:
+            // Only the branch that is taken gets evaluated
+            if (step == 0) return descend(child, ast, root->a, 0);
+            if (step == 1) {
+                Bool condition = evaluator->values.arr[--evaluator->values.len];
+                return descend(child, ast, condition ? root->b : root->c, 0);
+            }
+            return FALSE;
+        case EXPR_INDEX:
+            UNIMPLEMENTED("Index Expressions");
+        case EXPR_FUNC_CALL:
+            UNIMPLEMENTED("Function Call Expressions");
+        case EXPR_MEMBER:
+            UNIMPLEMENTED("Member Expressions");
+        case EXPR_COMPOUND_ASSIGN:
+            // The value a = a op b would assign
+            if (step < 2) return descend(child, ast, step == 0 ? root->a : root->b, 0);
+            rhs = evaluator->values.arr[--evaluator->values.len];
+            value = &evaluator->values.arr[evaluator->values.len - 1];
+            *value = evalBinaryOperator(compoundAssignOperator(root->op), *value, rhs);
+            return FALSE;
+        case EXPR_INCREMENT:
+            if (step == 0) return descend(child, ast, root->a, 0);
+            if (!root->b) return FALSE;
+            value = &evaluator->values.arr[evaluator->values.len - 1];
+            *value += root->op == TOK_PLUS_PLUS ? 1 : -1;
+            return FALSE;
+        case EXPR_CONSTANT:
+            WALK_RESULTS_PUSH(&evaluator->values, constantToInt(flatConstant(root)));
+            return FALSE;
+    }
+    printf("Unknown expression type: %d\n", root->type);
+    UNIMPLEMENTED("Don't come here");
+}
+
+/**********************************************************************************************************************
+ * Printing
+ *********************************************************************************************************************/
+
+typedef struct {
+    const SourceFile *source;
+    const FlatAst *ast;
+} FlatPrinter;
+
+static void printIndent(int indent) {
+    for (int i = 0; i < indent; i++) printf("  ");
+}
+
+// Start a field whose value is printed by walking into it
+static Bool printField(WalkNode *child, const FlatAst *ast, cstr name, FlatRef ref, usize indent) {
+    printIndent(indent);
+    printf("\"%s\": ", name);
+    return descend(child, ast, ref, indent);
+}
+
+static Bool printClose(usize indent) {
+    printIndent(indent);
+    printf("}\n");
+    return FALSE;
+}
+
+static Bool printFlatStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    const FlatPrinter *printer = ctx;
+    const FlatAst *ast = printer->ast;
+    const FlatNode *root = node.node;
+    usize indent = node.data;
+
+    if (step == 0) {
+        printf("{\n");
+        printIndent(indent + 1);
+        switch ((ExprType)root->type) {
+            case EXPR_LITERAL:
+                printf("\"type\": \"literal\",\n");
+                printIndent(indent + 1);
+                printf("\"token\": ");
+                printToken(printer->source, ast->tokens.arr[root->a]);
+                printf("\n");
+                return printClose(indent);
+            case EXPR_GROUPING:
+                printf("\"type\": \"grouping\",\n");
+                return printField(child, ast, "inner", root->a, indent + 1);
+            case EXPR_BINARY:
+                printf("\"type\": \"binary\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->op]);
+                return printField(child, ast, "lhs", root->a, indent + 1);
+            case EXPR_UNARY:
+                printf("\"type\": \"unary\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->op]);
+                return printField(child, ast, "inner", root->a, indent + 1);
+            case EXPR_CONDITIONAL:
+                printf("\"type\": \"conditional\",\n");
+                return printField(child, ast, "condition", root->a, indent + 1);
+            case EXPR_INDEX:
+                printf("\"type\": \"index\",\n");
+                return printField(child, ast, "name", root->a, indent + 1);
+            case EXPR_FUNC_CALL:
+                printf("\"type\": \"func_call\",\n");
+                return printField(child, ast, "callee", root->a, indent + 1);
+            case EXPR_MEMBER:
+                printf("\"type\": \"member\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->op]);
+                return printField(child, ast, "object", root->a, indent + 1);
+            case EXPR_COMPOUND_ASSIGN:
+                printf("\"type\": \"compound_assign\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->op]);
+                return printField(child, ast, "target", root->a, indent + 1);
+            case EXPR_INCREMENT:
+                printf("\"type\": \"increment\",\n");
+                printIndent(indent + 1);
+                printf("\"op\": \"%s\",\n", tokenTypesStrings[root->op]);
+                printIndent(indent + 1);
+                printf("\"prefix\": %s,\n", root->b ? "true" : "false");
+                return printField(child, ast, "target", root->a, indent + 1);
+            case EXPR_CONSTANT:
+                printf("\"type\": \"constant\",\n");
+                printIndent(indent + 1);
+                printf("\"value\": ");
+                printConstant(printer->source, flatConstant(root), root->a);
+                printf("\n");
+                return printClose(indent);
+        }
+    }
+
+    // Back from child `step - 1`
+    switch ((ExprType)root->type) {
+        case EXPR_BINARY:
+            if (step == 1) return printField(child, ast, "rhs", root->b, indent + 1);
+            break;
+        case EXPR_CONDITIONAL:
+            if (step == 1) return printField(child, ast, "then", root->b, indent + 1);
+            if (step == 2) return printField(child, ast, "else", root->c, indent + 1);
+            break;
+        case EXPR_INDEX:
+            if (step == 1) return printField(child, ast, "index", root->b, indent + 1);
+            break;
+        case EXPR_FUNC_CALL:
+            if (step == 1) {
+                printIndent(indent + 1);
+                printf("\"args\": [\n");
+            }
+            if (step <= root->c) {
+                printIndent(indent + 2);
+                return descend(child, ast, ast->args.arr[root->b + step - 1], indent + 2);
+            }
+            printIndent(indent + 1);
+            printf("]\n");
+            break;
+        case EXPR_MEMBER:
+            printIndent(indent + 1);
+            printf("\"member\": ");
+            printToken(printer->source, ast->tokens.arr[root->b]);
+            printf("\n");
+            break;
+        case EXPR_COMPOUND_ASSIGN:
+            if (step == 1) return printField(child, ast, "value", root->b, indent + 1);
+            break;
+        default:
+            break;
+    }
+    return printClose(indent);
+}
+
+/**********************************************************************************************************************
+ * Public Flat AST API
+ *********************************************************************************************************************/
+
+FlatRef flattenExpr(FlatAst *ast, const Expr *root) {
+    if (root == NULL) return FLAT_NONE;
+
+    Flattener flattener = {.ast = ast};
+    WALK_RESULTS_INIT(&flattener.refs);
+    walk((WalkNode){.kind = WALK_EXPR, .node = root}, flattenStep, &flattener);
+    FlatRef ref = flattener.refs.arr[0];
+    WALK_RESULTS_FREE(&flattener.refs);
+    return ref;
+}
+
+int evalFlatExpr(const FlatAst *ast, FlatRef root) {
+    FlatEvaluator evaluator = {.ast = ast};
+    WALK_RESULTS_INIT(&evaluator.values);
+    walk(flatNode(ast, root, 0), evalFlatStep, &evaluator);
+    int value = evaluator.values.arr[0];
+    WALK_RESULTS_FREE(&evaluator.values);
+    return value;
+}
+
+void printFlatExprImpl(const SourceFile *source, const FlatAst *ast, FlatRef root, usize indent) {
+    FlatPrinter printer = {.source = source, .ast = ast};
+    walk(flatNode(ast, root, indent), printFlatStep, &printer);
+}
+
+void printFlatExpr(const SourceFile *source, const FlatAst *ast, FlatRef root) {
+    if (root == FLAT_NONE) {
+        printf("null\n");
+        return;
+    }
+
+    printFlatExprImpl(source, ast, root, 0);
+}
+
+void freeFlatAst(FlatAst *ast) {
+    free(ast->nodes.arr);
+    free(ast->args.arr);
+    free(ast->tokens.arr);
+    *ast = (FlatAst){0};
+}
@@ -0,0 +1,521 @@
+#include "Fold.h"
+
+#include <float.h>
+#include <math.h>
+
+// Value of an operand along with where it starts, for the diagnostics
+typedef struct {
+    Constant value;
+    u32 offset;
+} Operand;
+
+static Bool isFloatType(TokenType type) { return type == TOK_F32 || type == TOK_F64; }
+
+static Bool isSignedType(TokenType type) {
+    return type == TOK_I8 || type == TOK_I16 || type == TOK_I32 || type == TOK_I64;
+}
+
+static Bool isPrimitiveType(TokenType type) {
+    switch (type) {
+        case TOK_BOOL:
+        case TOK_U8:
+        case TOK_U16:
+        case TOK_U32:
+        case TOK_U64:
+        case TOK_I8:
+        case TOK_I16:
+        case TOK_I32:
+        case TOK_I64:
+        case TOK_F32:
+        case TOK_F64:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+static u32 typeBits(TokenType type) {
+    switch (type) {
+        case TOK_BOOL:
+            return 1;
+        case TOK_U8:
+        case TOK_I8:
+            return 8;
+        case TOK_U16:
+        case TOK_I16:
+            return 16;
+        case TOK_U32:
+        case TOK_I32:
+        case TOK_F32:
+            return 32;
+        default:
+            return 64;
+    }
+}
+
+// Integer types narrower than i32 take part in arithmetic as i32
+static TokenType promote(TokenType type) { return !isFloatType(type) && typeBits(type) < 32 ? TOK_I32 : type; }
+
+// Type both operands of an arithmetic operator are converted to
+static TokenType commonType(TokenType lhs, TokenType rhs) {
+    if (lhs == TOK_F64 || rhs == TOK_F64) return TOK_F64;
+    if (lhs == TOK_F32 || rhs == TOK_F32) return TOK_F32;
+
+    lhs = promote(lhs);
+    rhs = promote(rhs);
+    if (lhs == rhs) return lhs;
+    if (isSignedType(lhs) == isSignedType(rhs)) return typeBits(lhs) >= typeBits(rhs) ? lhs : rhs;
+    // Mixed signedness: the unsigned type wins unless the signed one is wider and holds all of its values
+    TokenType unsignedType = isSignedType(lhs) ? rhs : lhs;
+    TokenType signedType = isSignedType(lhs) ? lhs : rhs;
+    return typeBits(unsignedType) >= typeBits(signedType) ? unsignedType : signedType;
+}
+
+// `value` cut down to the width of integer type `type`, sign extended for the signed types
+static u64 wrapInteger(TokenType type, u64 value) {
+    u32 bits = typeBits(type);
+    if (bits == 64) return value;
+
+    u64 mask = (1ull << bits) - 1;
+    value &= mask;
+    if (isSignedType(type) && value >> (bits - 1)) value |= ~mask;
+    return value;
+}
+
+// Round to float. Values out of its range become infinite as they would in float arithmetic, the cast itself is
+// undefined for them.
+static f64 roundToF32(f64 real) {
+    if (real > FLT_MAX) return INFINITY;
+    if (real < -FLT_MAX) return -INFINITY;
+    return (f32)real;
+}
+
+static Bool isTrue(Constant value) { return isFloatType(value.type) ? value.as.real != 0 : value.as.integer != 0; }
+
+// Result of a comparison or logical operator
+static Constant truthValue(Bool value) { return (Constant){.type = TOK_I32, .as.integer = value}; }
+
+// Convert `value` to `type` the way an assignment would. Returns FALSE if the value doesn't survive the conversion,
+// floats losing precision aside.
+static Bool convert(Constant *value, TokenType type) {
+    Constant from = *value;
+    value->type = type;
+
+    if (type == TOK_BOOL) {
+        value->as.integer = isTrue(from);
+        return TRUE;
+    }
+    if (isFloatType(type)) {
+        f64 real = from.as.real;
+        if (!isFloatType(from.type)) real = isSignedType(from.type) ? (f64)(i64)from.as.integer : (f64)from.as.integer;
+        value->as.real = type == TOK_F32 ? roundToF32(real) : real;
+        return isinf(value->as.real) == isinf(real);
+    }
+    if (isFloatType(from.type)) {
+        // Out of range conversions are undefined, NaN included, so they are checked before the cast
+        f64 real = from.as.real;
+        f64 limit = 2.0 * (f64)(1ull << (typeBits(type) - 1));
+        Bool inRange = isSignedType(type) ? real + limit / 2 > -1 && real < limit / 2 : real > -1 && real < limit;
+        value->as.integer = !inRange ? 0 : isSignedType(type) ? (u64)(i64)real : (u64)real;
+        return inRange;
+    }
+
+    value->as.integer = wrapInteger(type, from.as.integer);
+    // The same bits still mean another number when only one side reads them as signed
+    Bool wasNegative = isSignedType(from.type) && (i64)from.as.integer < 0;
+    Bool isNegative = isSignedType(type) && (i64)value->as.integer < 0;
+    // Except negative values going unsigned, -1 for all bits set is as common as it is well defined. Those only have
+    // to fit the signed type of the same width.
+    if (wasNegative && !isSignedType(type))
+        return typeBits(type) == 64 || (i64)from.as.integer >= -(i64)(1ull << (typeBits(type) - 1));
+    return value->as.integer == from.as.integer && wasNegative == isNegative;
+}
+
+// Value of a numeric literal or an already folded node, FALSE for anything else
+static Bool operandOf(const Expr *expr, Operand *operand) {
+    if (expr->type == EXPR_CONSTANT) {
+        *operand = (Operand){.value = expr->as.constant.value, .offset = expr->as.constant.offset};
+        return TRUE;
+    }
+    if (expr->type != EXPR_LITERAL) return FALSE;
+
+    Token token = expr->as.primary.value;
+    operand->offset = token.offset;
+    switch (token.type) {
+        case TOK_INTEGER_LITERAL: {
+            u64 integer = token.as.integerLiteral;
+            TokenType type = integer <= INT32_MAX ? TOK_I32 : integer <= INT64_MAX ? TOK_I64 : TOK_U64;
+            operand->value = (Constant){.type = type, .as.integer = integer};
+            return TRUE;
+        }
+        case TOK_FLOAT_LITERAL:
+            operand->value = (Constant){.type = TOK_F64, .as.real = token.as.floatLiteral};
+            return TRUE;
+        case TOK_CHAR_LITERAL:
+            operand->value = (Constant){.type = TOK_U8, .as.integer = token.as.charLiteral};
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+// `diagnostics` is NULL while folding an operand that is never evaluated, its errors would never happen
+static Bool fail(Diagnostics *diagnostics, u32 offset, cstr message) {
+    if (diagnostics != NULL) reportDiagnostic(diagnostics, offset, message);
+    return FALSE;
+}
+
+/**********************************************************************************************************************
+ * Operators
+ * Each returns TRUE with the result in its operand, or FALSE if the operator can't be folded. Errors are reported
+ * through `fail`.
+ *********************************************************************************************************************/
+
+static Bool foldUnary(Diagnostics *diagnostics, TokenType op, Operand *operand) {
+    Constant *value = &operand->value;
+    switch (op) {
+        case TOK_PLUS:
+        case TOK_MINUS:
+        case TOK_TILDE:
+            break;
+        case TOK_BANG:
+            *value = truthValue(!isTrue(*value));
+            return TRUE;
+        default:
+            // Address of, dereference and increments need an object
+            return FALSE;
+    }
+
+    if (isFloatType(value->type)) {
+        if (op == TOK_TILDE) return fail(diagnostics, operand->offset, "Operator needs integer operands");
+        if (op == TOK_MINUS) value->as.real = -value->as.real;
+        return TRUE;
+    }
+
+    TokenType type = promote(value->type);
+    convert(value, type);
+    u64 integer = value->as.integer;
+    u64 result = op == TOK_MINUS ? 0 - integer : op == TOK_TILDE ? ~integer : integer;
+    if (op == TOK_MINUS && isSignedType(type) && (wrapInteger(type, result) != result || integer == 1ull << 63))
+        return fail(diagnostics, operand->offset, "Integer overflow in constant expression");
+
+    value->as.integer = wrapInteger(type, result);
+    return TRUE;
+}
+
+// The result has the promoted type of the left side, the two sides are not converted to a common type
+static Bool foldShift(Diagnostics *diagnostics, TokenType op, Operand lhs, Operand rhs, Operand *result) {
+    if (isFloatType(lhs.value.type) || isFloatType(rhs.value.type))
+        return fail(diagnostics, lhs.offset, "Operator needs integer operands");
+
+    TokenType type = promote(lhs.value.type);
+    convert(&lhs.value, type);
+    u64 count = rhs.value.as.integer;
+    if ((isSignedType(rhs.value.type) && (i64)count < 0) || count >= typeBits(type))
+        return fail(diagnostics, rhs.offset, "Shift count out of range");
+
+    u64 integer = lhs.value.as.integer;
+    u64 shifted;
+    if (op == TOK_LESS_LESS) {
+        shifted = integer << count;
+        // Shifting a negative value or a bit into the sign is undefined
+        if (isSignedType(type) &&
+            ((i64)integer < 0 || (i64)shifted >> count != (i64)integer || wrapInteger(type, shifted) != shifted))
+            return fail(diagnostics, lhs.offset, "Integer overflow in constant expression");
+    } else {
+        shifted = isSignedType(type) ? (u64)((i64)integer >> count) : integer >> count;
+    }
+
+    *result = (Operand){.value = {.type = type, .as.integer = wrapInteger(type, shifted)}, .offset = lhs.offset};
+    return TRUE;
+}
+
+static Bool foldFloatBinary(Diagnostics *diagnostics, TokenType op, TokenType type, Operand lhs, Operand rhs,
+                            Operand *result) {
+    f64 l = lhs.value.as.real, r = rhs.value.as.real, real;
+    result->offset = lhs.offset;
+    switch (op) {
+        case TOK_PLUS:
+            real = l + r;
+            break;
+        case TOK_MINUS:
+            real = l - r;
+            break;
+        case TOK_STAR:
+            real = l * r;
+            break;
+        case TOK_SLASH:
+            real = l / r;
+            break;
+        case TOK_EQUALS_EQUALS:
+            result->value = truthValue(l == r);
+            return TRUE;
+        case TOK_BANG_EQUALS:
+            result->value = truthValue(l != r);
+            return TRUE;
+        case TOK_LESS:
+            result->value = truthValue(l < r);
+            return TRUE;
+        case TOK_LESS_EQUALS:
+            result->value = truthValue(l <= r);
+            return TRUE;
+        case TOK_GREATER:
+            result->value = truthValue(l > r);
+            return TRUE;
+        case TOK_GREATER_EQUALS:
+            result->value = truthValue(l >= r);
+            return TRUE;
+        default:
+            return fail(diagnostics, lhs.offset, "Operator needs integer operands");
+    }
+
+    // Both sides are exact in f64 and so is a single operation on them, rounding that once is the f32 result
+    result->value = (Constant){.type = type, .as.real = type == TOK_F32 ? roundToF32(real) : real};
+    return TRUE;
+}
+
+static Bool foldIntegerBinary(Diagnostics *diagnostics, TokenType op, TokenType type, Operand lhs, Operand rhs,
+                              Operand *result) {
+    u64 l = lhs.value.as.integer, r = rhs.value.as.integer, integer;
+    Bool isSigned = isSignedType(type);
+    // Set for 64 bit signed overflow, narrower types are checked against their width below
+    Bool overflow = FALSE;
+    i64 ignored;
+    result->offset = lhs.offset;
+
+    switch (op) {
+        case TOK_PLUS:
+            integer = l + r;
+            overflow = isSigned && __builtin_add_overflow((i64)l, (i64)r, &ignored);
+            break;
+        case TOK_MINUS:
+            integer = l - r;
+            overflow = isSigned && __builtin_sub_overflow((i64)l, (i64)r, &ignored);
+            break;
+        case TOK_STAR:
+            integer = l * r;
+            overflow = isSigned && __builtin_mul_overflow((i64)l, (i64)r, &ignored);
+            break;
+        case TOK_SLASH:
+        case TOK_PERCENT:
+            if (r == 0) return fail(diagnostics, rhs.offset, "Division by zero in constant expression");
+            if (isSigned && (i64)r == -1) {
+                // The one quotient that overflows, and a remainder the hardware traps on
+                integer = op == TOK_SLASH ? 0 - l : 0;
+                overflow = op == TOK_SLASH && l == 1ull << 63;
+            } else if (isSigned) {
+                integer = op == TOK_SLASH ? (u64)((i64)l / (i64)r) : (u64)((i64)l % (i64)r);
+            } else {
+                integer = op == TOK_SLASH ? l / r : l % r;
+            }
+            break;
+        case TOK_AMPERSAND:
+            integer = l & r;
+            break;
+        case TOK_PIPE:
+            integer = l | r;
+            break;
+        case TOK_CARET:
+            integer = l ^ r;
+            break;
+        case TOK_EQUALS_EQUALS:
+            result->value = truthValue(l == r);
+            return TRUE;
+        case TOK_BANG_EQUALS:
+            result->value = truthValue(l != r);
+            return TRUE;
+        case TOK_LESS:
+            result->value = truthValue(isSigned ? (i64)l < (i64)r : l < r);
+            return TRUE;
+        case TOK_LESS_EQUALS:
+            result->value = truthValue(isSigned ? (i64)l <= (i64)r : l <= r);
+            return TRUE;
+        case TOK_GREATER:
+            result->value = truthValue(isSigned ? (i64)l > (i64)r : l > r);
+            return TRUE;
+        case TOK_GREATER_EQUALS:
+            result->value = truthValue(isSigned ? (i64)l >= (i64)r : l >= r);
+            return TRUE;
+        default:
+            return FALSE;
+    }
+
+    // Unsigned arithmetic wraps, signed arithmetic must fit
+    u64 wrapped = wrapInteger(type, integer);
+    if (isSigned && (overflow || wrapped != integer))
+        return fail(diagnostics, lhs.offset, "Integer overflow in constant expression");
+
+    result->value = (Constant){.type = type, .as.integer = wrapped};
+    return TRUE;
+}
+
+static Bool foldBinary(Diagnostics *diagnostics, TokenType op, Operand lhs, Operand rhs, Operand *result) {
+    switch (op) {
+        case TOK_COMMA:
+            *result = (Operand){.value = rhs.value, .offset = lhs.offset};
+            return TRUE;
+        case TOK_AMPERSAND_AMPERSAND:
+            *result = (Operand){.value = truthValue(isTrue(lhs.value) && isTrue(rhs.value)), .offset = lhs.offset};
+            return TRUE;
+        case TOK_PIPE_PIPE:
+            *result = (Operand){.value = truthValue(isTrue(lhs.value) || isTrue(rhs.value)), .offset = lhs.offset};
+            return TRUE;
+        case TOK_LESS_LESS:
+        case TOK_GREATER_GREATER:
+            return foldShift(diagnostics, op, lhs, rhs, result);
+        case TOK_EQUALS:
+            return FALSE;
+        default:
+            break;
+    }
+
+    TokenType type = commonType(lhs.value.type, rhs.value.type);
+    // Changing the value is what the conversion is for, a negative value turned unsigned for one
+    convert(&lhs.value, type);
+    convert(&rhs.value, type);
+    if (isFloatType(type)) return foldFloatBinary(diagnostics, op, type, lhs, rhs, result);
+    return foldIntegerBinary(diagnostics, op, type, lhs, rhs, result);
+}
+
+/**********************************************************************************************************************
+ * Walking
+ *********************************************************************************************************************/
+
+// Whether child `step` of `root` is never evaluated, because the constant left side of a && or || or the constant
+// condition of a ?: already decided against it
+static Bool isUnevaluated(const Expr *root, u32 step) {
+    Operand decider;
+    if (root->type == EXPR_BINARY) {
+        TokenType op = root->as.binary.op;
+        if (step != 1 || (op != TOK_AMPERSAND_AMPERSAND && op != TOK_PIPE_PIPE)) return FALSE;
+        return operandOf(root->as.binary.lhs, &decider) && isTrue(decider.value) == (op == TOK_PIPE_PIPE);
+    }
+    if (root->type != EXPR_CONDITIONAL || step == 0) return FALSE;
+    return operandOf(root->as.conditional.condition, &decider) && isTrue(decider.value) != (step == 1);
+}
+
+// Folds a node once all of its children have been folded. The node data is set below operands that are never
+// evaluated, which are folded without reporting errors.
+static Bool foldStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    Diagnostics *diagnostics = node.data != 0 ? NULL : ctx;
+    // Walks hand out const nodes, this pass owns the tree it rewrites
+    Expr *root = (Expr *)node.node;
+
+    const Expr *next = exprChild(root, step);
+    if (next != NULL) {
+        Bool unevaluated = isUnevaluated(root, step);
+        // The untaken branch of a ?: still gives the result its type, the right side of && and || doesn't matter
+        if (!unevaluated || root->type == EXPR_CONDITIONAL) {
+            *child = (WalkNode){.kind = WALK_EXPR, .node = next, .data = node.data != 0 || unevaluated};
+            return TRUE;
+        }
+    }
+
+    Operand lhs, rhs, result;
+    switch (root->type) {
+        case EXPR_GROUPING:
+            if (!operandOf(root->as.grouping.inner, &result)) return FALSE;
+            break;
+        case EXPR_UNARY:
+            if (!operandOf(root->as.unary.inner, &result)) return FALSE;
+            if (!foldUnary(diagnostics, root->as.unary.op, &result)) return FALSE;
+            break;
+        case EXPR_BINARY: {
+            TokenType op = root->as.binary.op;
+            if (!operandOf(root->as.binary.lhs, &lhs)) return FALSE;
+            // Decided by the left side alone, the right one is never evaluated and needn't be constant
+            Bool isLogical = op == TOK_AMPERSAND_AMPERSAND || op == TOK_PIPE_PIPE;
+            if (isLogical && isTrue(lhs.value) == (op == TOK_PIPE_PIPE)) {
+                result = (Operand){.value = truthValue(op == TOK_PIPE_PIPE), .offset = lhs.offset};
+                break;
+            }
+            if (!operandOf(root->as.binary.rhs, &rhs)) return FALSE;
+            if (!foldBinary(diagnostics, op, lhs, rhs, &result)) return FALSE;
+            break;
+        }
+        case EXPR_CONDITIONAL: {
+            Operand condition, thenBranch, elseBranch;
+            if (!operandOf(root->as.conditional.condition, &condition)) return FALSE;
+            if (!operandOf(root->as.conditional.thenBranch, &thenBranch)) return FALSE;
+            if (!operandOf(root->as.conditional.elseBranch, &elseBranch)) return FALSE;
+
+            // Whichever branch is taken, the result has the type both would be converted to
+            TokenType type = commonType(thenBranch.value.type, elseBranch.value.type);
+            result = isTrue(condition.value) ? thenBranch : elseBranch;
+            convert(&result.value, type);
+            result.offset = condition.offset;
+            break;
+        }
+        default:
+            return FALSE;
+    }
+
+    root->type = EXPR_CONSTANT;
+    root->as.constant = (ConstantExpr){.value = result.value, .offset = result.offset};
+    return FALSE;
+}
+
+static void foldArraySize(Expr *size, Diagnostics *diagnostics) {
+    Operand operand;
+    foldExpr(size, diagnostics);
+    if (size == NULL || !operandOf(size, &operand)) return;
+
+    if (isFloatType(operand.value.type))
+        reportDiagnostic(diagnostics, operand.offset, "Array size must be an integer");
+    else if (isSignedType(operand.value.type) && (i64)operand.value.as.integer < 0)
+        reportDiagnostic(diagnostics, operand.offset, "Array size is negative");
+}
+
+static void foldType(Type *type, Diagnostics *diagnostics) {
+    while (type != NULL) {
+        switch (type->kind) {
+            case TYPE_SIMPLE:
+                return;
+            case TYPE_POINTER:
+                type = type->as.pointer;
+                break;
+            case TYPE_ARRAY:
+                foldArraySize(type->as.array.size, diagnostics);
+                type = type->as.array.inner;
+                break;
+        }
+    }
+}
+
+// A constant initializer of a primitive variable becomes a constant of the variable's type, even when it doesn't fit
+static void foldInitializer(const Type *type, Expr *initializer, Diagnostics *diagnostics) {
+    Operand operand;
+    foldExpr(initializer, diagnostics);
+    if (initializer == NULL || type->kind != TYPE_SIMPLE || !isPrimitiveType(type->as.simple.type)) return;
+    if (!operandOf(initializer, &operand)) return;
+
+    // A constant that doesn't fit is reported and still converted, the initializer holds the value the assignment
+    // would store rather than one of a type the variable doesn't have
+    if (!convert(&operand.value, type->as.simple.type))
+        reportDiagnostic(diagnostics, operand.offset, "Constant does not fit in the declared type");
+    initializer->type = EXPR_CONSTANT;
+    initializer->as.constant = (ConstantExpr){.value = operand.value, .offset = operand.offset};
+}
+
+/**********************************************************************************************************************
+ * Public Folding API
+ *********************************************************************************************************************/
+
+void foldExpr(Expr *root, Diagnostics *diagnostics) {
+    if (root == NULL) return;
+    walk((WalkNode){.kind = WALK_EXPR, .node = root}, foldStep, diagnostics);
+}
+
+void foldStmtList(StmtList list, Diagnostics *diagnostics) {
+    for (usize i = 0; i < list.len; i++) {
+        Stmt *stmt = list.arr[i];
+        switch (stmt->type) {
+            case STMT_DECLARATION:
+                foldType(stmt->as.declaration.type, diagnostics);
+                foldInitializer(stmt->as.declaration.type, stmt->as.declaration.initializer, diagnostics);
+                break;
+            case STMT_ENUM:
+                break;
+        }
+    }
+}
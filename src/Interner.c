@@ -0,0 +1,106 @@
+#include "Interner.h"
+
+#include <libk/Errors.h>
+
+#include <string.h>
+
+#define INTERNER_INITIAL_SLOTS 1024
+#define INTERNER_BLOCK_SIZE (64 * 1024)
+
+static InternTable interner = {0};
+
+// FNV-1a
+static u32 hashText(String text) {
+    u32 hash = 2166136261u;
+    for (usize i = 0; i < text.len; i++) {
+        hash ^= text.data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static u8 *storeText(InternTable *table, String text) {
+    if (table->blockCap - table->blockUsed < text.len) {
+        usize blockCap = text.len > INTERNER_BLOCK_SIZE ? text.len : INTERNER_BLOCK_SIZE;
+        u8 *block = malloc(blockCap);
+        if (block == NULL) exit(1);
+        appendSingle(&table->blocks, block);
+        table->blockUsed = 0;
+        table->blockCap = blockCap;
+    }
+
+    u8 *dest = table->blocks.arr[table->blocks.len - 1] + table->blockUsed;
+    memcpy(dest, text.data, text.len);
+    table->blockUsed += text.len;
+    return dest;
+}
+
+static void growSlots(InternTable *table) {
+    usize newCap = table->slotsCap == 0 ? INTERNER_INITIAL_SLOTS : table->slotsCap * 2;
+    u32 *newSlots = calloc(newCap, sizeof(u32));
+    if (newSlots == NULL) exit(1);
+
+    // Rehash from the entries, their hashes are kept so no text is touched
+    for (usize symbol = 0; symbol < table->entries.len; symbol++) {
+        usize slot = table->entries.arr[symbol].hash & (newCap - 1);
+        while (newSlots[slot] != 0) slot = (slot + 1) & (newCap - 1);
+        newSlots[slot] = (u32)symbol + 1;
+    }
+
+    free(table->slots);
+    table->slots = newSlots;
+    table->slotsCap = newCap;
+}
+
+/**********************************************************************************************************************
+ * Public Interner API
+ *********************************************************************************************************************/
+
+Symbol internInto(InternTable *table, String text) {
+    // Keep the load factor under 1/2
+    if ((table->entries.len + 1) * 2 > table->slotsCap) growSlots(table);
+
+    u32 hash = hashText(text);
+    usize mask = table->slotsCap - 1;
+    usize slot = hash & mask;
+
+    while (table->slots[slot] != 0) {
+        Symbol symbol = table->slots[slot] - 1;
+        InternEntry *entry = &table->entries.arr[symbol];
+        if (entry->hash == hash && entry->text.len == text.len && memcmp(entry->text.data, text.data, text.len) == 0)
+            return symbol;
+        slot = (slot + 1) & mask;
+    }
+
+    Symbol symbol = (Symbol)table->entries.len;
+    InternEntry entry = {
+        .text = {.data = storeText(table, text), .len = text.len},
+        .hash = hash,
+    };
+    appendSingle(&table->entries, entry);
+    table->slots[slot] = symbol + 1;
+    return symbol;
+}
+
+String internTableText(const InternTable *table, Symbol symbol) {
+    ILLEGAL(symbol >= table->entries.len, "Unknown symbol");
+    return table->entries.arr[symbol].text;
+}
+
+void freeInternTable(InternTable *table) {
+    for (usize i = 0; i < table->blocks.len; i++) free(table->blocks.arr[i]);
+    free(table->blocks.arr);
+    free(table->entries.arr);
+    free(table->slots);
+    *table = (InternTable){0};
+}
+
+InternTable *globalInterner(void) { return &interner; }
+
+Symbol intern(String text) { return internInto(&interner, text); }
+
+String symbolText(Symbol symbol) { return internTableText(&interner, symbol); }
+
+usize internedCount(void) { return interner.entries.len; }
+
+void freeInterner(void) { freeInternTable(&interner); }
@@ -0,0 +1,357 @@
+#include "Jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64
+#endif
+
+#ifdef JIT_X86_64
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Larger frames run in the VM, whose registers go on the heap instead of a possibly small thread stack
+#define JIT_MAX_FRAME (64 * 1024)
+
+#define NO_REGISTER U32_MAX
+
+// x86 registers by their ModRM number
+typedef enum {
+    EAX = 0,
+    ECX = 1,
+    EDX = 2,
+} X86Register;
+
+typedef struct {
+    const Bytecode *bytecode;
+    u32 variablesStart; // First register of the variables
+    u32 tempsStart;     // First register of the temporaries
+    struct {
+        LIST_FIELDS(u8);
+    } out;
+    u32 cached; // Bytecode register whose value eax still holds, NO_REGISTER if unknown
+} Assembler;
+
+static void emitByte(Assembler *as, u8 byte) { appendSingle(&as->out, byte); }
+
+static void emitBytes(Assembler *as, const u8 *bytes, usize len) {
+    for (usize i = 0; i < len; i++) emitByte(as, bytes[i]);
+}
+
+#define EMIT(as, ...) emitBytes(as, (const u8[]){__VA_ARGS__}, sizeof((const u8[]){__VA_ARGS__}))
+
+static void emit32(Assembler *as, u32 value) {
+    for (u32 i = 0; i < 4; i++) emitByte(as, (u8)(value >> (8 * i)));
+}
+
+static Bool isConstant(const Assembler *as, u32 reg) { return reg < as->variablesStart; }
+
+static u32 constantValue(const Assembler *as, u32 reg) { return (u32)as->bytecode->constants.arr[reg]; }
+
+// ModRM and displacement addressing bytecode register `reg` in memory, variables in env (rdi), temporaries in the
+// frame (rsp)
+static void emitMemory(Assembler *as, X86Register x86, u32 reg) {
+    Bool isVariable = reg < as->tempsStart;
+    u32 offset = 4 * (reg - (isVariable ? as->variablesStart : as->tempsStart));
+    u8 mod = offset < 128 ? 0x40 : 0x80; // disp8 or disp32
+    if (isVariable) {
+        emitByte(as, mod | x86 << 3 | 7); // [rdi + disp]
+    } else {
+        EMIT(as, mod | x86 << 3 | 4, 0x24); // [rsp + disp]
+    }
+    if (offset < 128) {
+        emitByte(as, (u8)offset);
+    } else {
+        emit32(as, offset);
+    }
+}
+
+static void emitLoad(Assembler *as, X86Register x86, u32 reg) {
+    if (x86 == EAX && as->cached == reg) return;
+
+    if (isConstant(as, reg)) {
+        emitByte(as, 0xB8 + x86); // mov r32, imm32
+        emit32(as, constantValue(as, reg));
+    } else {
+        emitByte(as, 0x8B); // mov r32, r/m32
+        emitMemory(as, x86, reg);
+    }
+    if (x86 == EAX) as->cached = reg;
+}
+
+// eax = eax op b, through the eax, imm32 form for constants
+static void emitArithmetic(Assembler *as, u8 memoryOpcode, u8 immediateOpcode, u32 b) {
+    if (isConstant(as, b)) {
+        emitByte(as, immediateOpcode);
+        emit32(as, constantValue(as, b));
+    } else {
+        emitByte(as, memoryOpcode);
+        emitMemory(as, EAX, b);
+    }
+}
+
+// eax = 1 if the flags satisfy `condition`, 0 otherwise
+static void emitSetFlag(Assembler *as, u8 condition) {
+    EMIT(as, 0x0F, 0x90 | condition, 0xC0); // setcc al
+    EMIT(as, 0x0F, 0xB6, 0xC0);             // movzx eax, al
+}
+
+// Condition codes of setcc and jcc
+enum {
+    CC_EQUAL = 0x4,
+    CC_NOT_EQUAL = 0x5,
+    CC_LESS = 0xC,
+    CC_GREATER_EQUAL = 0xD,
+    CC_LESS_EQUAL = 0xE,
+    CC_GREATER = 0xF,
+};
+
+static Bool isCommutative(Opcode op) {
+    switch (op) {
+        case OP_ADD:
+        case OP_MUL:
+        case OP_BIT_AND:
+        case OP_BIT_XOR:
+        case OP_BIT_OR:
+        case OP_OR:
+        case OP_AND:
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+            return TRUE;
+        default:
+            return FALSE;
+    }
+}
+
+// Whether `next` takes the value of temporary `reg` from eax and leaves it dead, so it never has to be stored
+static Bool consumesFromEax(const Instruction *next, u32 reg) {
+    switch ((Opcode)next->op) {
+        case OP_RETURN:
+            return next->a == reg;
+        case OP_JUMP:
+        case OP_JUMP_IF_FALSE:
+            return FALSE;
+        case OP_MOVE:
+        case OP_NEG:
+        case OP_BIT_NOT:
+        case OP_NOT:
+            return next->a == reg && next->dest == reg;
+        default:
+            if (next->dest != reg || (next->a == reg) == (next->b == reg)) return FALSE;
+            return next->a == reg || isCommutative(next->op);
+    }
+}
+
+static void emitBinary(Assembler *as, Opcode op, u32 b) {
+    switch (op) {
+        case OP_ADD:
+            emitArithmetic(as, 0x03, 0x05, b);
+            break;
+        case OP_SUB:
+            emitArithmetic(as, 0x2B, 0x2D, b);
+            break;
+        case OP_BIT_AND:
+            emitArithmetic(as, 0x23, 0x25, b);
+            break;
+        case OP_BIT_OR:
+            emitArithmetic(as, 0x0B, 0x0D, b);
+            break;
+        case OP_BIT_XOR:
+            emitArithmetic(as, 0x33, 0x35, b);
+            break;
+        case OP_MUL:
+            if (isConstant(as, b)) {
+                EMIT(as, 0x69, 0xC0); // imul eax, eax, imm32
+                emit32(as, constantValue(as, b));
+            } else {
+                EMIT(as, 0x0F, 0xAF); // imul eax, r/m32
+                emitMemory(as, EAX, b);
+            }
+            break;
+        case OP_DIV:
+        case OP_MOD:
+            // Traps on 0 and INT_MIN / -1 like the compiled evaluators do
+            emitLoad(as, ECX, b);
+            EMIT(as, 0x99, 0xF7, 0xF9); // cdq, idiv ecx
+            if (op == OP_MOD) EMIT(as, 0x89, 0xD0); // mov eax, edx
+            break;
+        case OP_SHL:
+        case OP_SHR:
+            emitLoad(as, ECX, b);
+            EMIT(as, 0xD3, op == OP_SHL ? 0xE0 : 0xF8); // shl / sar eax, cl
+            break;
+        case OP_OR:
+            emitLoad(as, ECX, b);
+            EMIT(as, 0x09, 0xC8); // or eax, ecx
+            emitSetFlag(as, CC_NOT_EQUAL);
+            break;
+        case OP_AND:
+            emitLoad(as, ECX, b);
+            EMIT(as, 0x85, 0xC0, 0x0F, 0x95, 0xC0); // test eax, eax; setne al
+            EMIT(as, 0x85, 0xC9, 0x0F, 0x95, 0xC1); // test ecx, ecx; setne cl
+            EMIT(as, 0x20, 0xC8, 0x0F, 0xB6, 0xC0); // and al, cl; movzx eax, al
+            break;
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL: {
+            emitArithmetic(as, 0x3B, 0x3D, b); // cmp
+            static const u8 conditions[] = {
+                [OP_EQUAL] = CC_EQUAL, [OP_NOT_EQUAL] = CC_NOT_EQUAL,   [OP_LESS] = CC_LESS,
+                [OP_LESS_EQUAL] = CC_LESS_EQUAL, [OP_GREATER] = CC_GREATER, [OP_GREATER_EQUAL] = CC_GREATER_EQUAL,
+            };
+            emitSetFlag(as, conditions[op]);
+            break;
+        }
+        default:
+            UNREACHABLE("Not a binary opcode");
+    }
+}
+
+// Generate the function into as->out, FALSE if it needs a frame larger than JIT_MAX_FRAME
+static Bool assemble(Assembler *as) {
+    const Bytecode *bytecode = as->bytecode;
+    usize count = bytecode->code.len;
+    usize frame = 4 * (bytecode->registerCount - as->tempsStart);
+    if (frame > JIT_MAX_FRAME) return FALSE;
+    frame = (frame + 15) & ~(usize)15;
+
+    // Where every instruction starts, and the rel32 fields that jump to one
+    u32 *offsets = malloc((count + 1) * sizeof(u32));
+    Bool *isTarget = calloc(count + 1, sizeof(Bool));
+    struct {
+        LIST_FIELDS(usize);
+    } fixups = {0};
+    if (offsets == NULL || isTarget == NULL) exit(1);
+    for (usize i = 0; i < count; i++) {
+        Opcode op = bytecode->code.arr[i].op;
+        if (op == OP_JUMP || op == OP_JUMP_IF_FALSE) isTarget[bytecode->code.arr[i].b] = TRUE;
+    }
+
+    if (frame > 0) {
+        EMIT(as, 0x48, 0x81, 0xEC); // sub rsp, imm32
+        emit32(as, (u32)frame);
+    }
+    for (usize i = 0; i < count; i++) {
+        const Instruction *instr = &bytecode->code.arr[i];
+        offsets[i] = (u32)as->out.len;
+        // Whatever eax holds depends on the way the instruction was reached
+        if (isTarget[i]) as->cached = NO_REGISTER;
+
+        switch ((Opcode)instr->op) {
+            case OP_RETURN:
+                emitLoad(as, EAX, instr->a);
+                if (frame > 0) {
+                    EMIT(as, 0x48, 0x81, 0xC4); // add rsp, imm32
+                    emit32(as, (u32)frame);
+                }
+                emitByte(as, 0xC3); // ret
+                continue;
+            case OP_JUMP:
+                emitByte(as, 0xE9); // jmp rel32
+                appendSingle(&fixups, as->out.len);
+                emit32(as, instr->b);
+                continue;
+            case OP_JUMP_IF_FALSE:
+                emitLoad(as, EAX, instr->a);
+                EMIT(as, 0x85, 0xC0, 0x0F, 0x84); // test eax, eax; je rel32
+                appendSingle(&fixups, as->out.len);
+                emit32(as, instr->b);
+                continue;
+            case OP_MOVE:
+                emitLoad(as, EAX, instr->a);
+                break;
+            case OP_NEG:
+                emitLoad(as, EAX, instr->a);
+                EMIT(as, 0xF7, 0xD8); // neg eax
+                break;
+            case OP_BIT_NOT:
+                emitLoad(as, EAX, instr->a);
+                EMIT(as, 0xF7, 0xD0); // not eax
+                break;
+            case OP_NOT:
+                emitLoad(as, EAX, instr->a);
+                EMIT(as, 0x85, 0xC0); // test eax, eax
+                emitSetFlag(as, CC_EQUAL);
+                break;
+            default:
+                if (as->cached == instr->b && instr->a != instr->b && isCommutative(instr->op)) {
+                    emitBinary(as, instr->op, instr->a);
+                } else {
+                    emitLoad(as, EAX, instr->a);
+                    emitBinary(as, instr->op, instr->b);
+                }
+                break;
+        }
+        // Every other instruction leaves its result in eax, where a chain of operators keeps it
+        as->cached = instr->dest;
+        if (i + 1 < count && !isTarget[i + 1] && consumesFromEax(&bytecode->code.arr[i + 1], instr->dest)) continue;
+        emitByte(as, 0x89); // mov r/m32, eax
+        emitMemory(as, EAX, instr->dest);
+    }
+    offsets[count] = (u32)as->out.len;
+
+    // The rel32 fields hold the target instruction for now
+    for (usize i = 0; i < fixups.len; i++) {
+        u8 *field = as->out.arr + fixups.arr[i];
+        u32 target;
+        memcpy(&target, field, sizeof(target));
+        u32 rel = offsets[target] - (u32)(fixups.arr[i] + 4);
+        memcpy(field, &rel, sizeof(rel));
+    }
+
+    free(fixups.arr);
+    free(isTarget);
+    free(offsets);
+    return TRUE;
+}
+
+// Copy the code into a mapping of its own and make it executable
+static Bool install(JitExpr *jit, const u8 *code, usize len) {
+    usize page = (usize)sysconf(_SC_PAGESIZE);
+    usize size = (len + page - 1) / page * page;
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return FALSE;
+
+    memcpy(memory, code, len);
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return FALSE;
+    }
+    jit->memory = memory;
+    jit->size = size;
+    // ISO C has no conversion from object to function pointers, POSIX guarantees the representations match
+    memcpy(&jit->function, &memory, sizeof(memory));
+    return TRUE;
+}
+#endif
+
+/**********************************************************************************************************************
+ * Public JIT API
+ *********************************************************************************************************************/
+
+Bool jitCompileExpr(JitExpr *jit, const Expr *root) {
+    *jit = (JitExpr){0};
+    if (!compileExpr(&jit->bytecode, root)) return FALSE;
+
+#ifdef JIT_X86_64
+    Assembler as = {
+        .bytecode = &jit->bytecode,
+        .variablesStart = (u32)jit->bytecode.constants.len,
+        .tempsStart = (u32)(jit->bytecode.constants.len + jit->bytecode.variables.len),
+        .cached = NO_REGISTER,
+    };
+    if (assemble(&as)) install(jit, as.out.arr, as.out.len);
+    free(as.out.arr);
+#endif
+    return TRUE;
+}
+
+void freeJitExpr(JitExpr *jit) {
+#ifdef JIT_X86_64
+    if (jit->memory != NULL) munmap(jit->memory, jit->size);
+#endif
+    freeBytecode(&jit->bytecode);
+    *jit = (JitExpr){0};
+}
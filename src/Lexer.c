@@ -1,9 +1,11 @@
 #include "Lexer.h"
+#include "Number.h"
+#include "Scan.h"
 
 #include <libk/StringBuilder.h>
 
 #include <assert.h>
-#include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,24 +28,19 @@ static inline u8 octToVal(u8 c) {
     assert(FALSE && "Called octToVal with non octal character!");
 }
 
-typedef struct {
-    String input;
-    String fileName;
-    usize line;
-    usize col;
-    usize index;
-    TokensList *tokens;
-    Bool hasErros;
-} Lexer;
-
-
 static inline void addToken(Lexer *l, Token token) {
-    appendSingle(l->tokens, token);
+    if (l->ring != NULL) {
+        TokenRing *ring = l->ring;
+        ring->slots[(ring->head + ring->count) & (TOKEN_RING_SIZE - 1)] = token;
+        ring->count++;
+    } else {
+        appendSingle(l->tokens, token);
+    }
     if (token.type == TOK_ERROR) l->hasErros = TRUE;
 }
 
 static void addSimpleToken(Lexer *l, TokenType type) {
-    Token t = makeSimple(type, l->line, l->col);
+    Token t = makeSimple(type, l->start);
     addToken(l, t);
 }
 
@@ -53,19 +50,9 @@ static Bool isAtEnd(Lexer *l) { return l->index == l->input.len; }
 // Advance the lexer and return the current character
 static u8 advance(Lexer *l) {
     if (isAtEnd(l)) return 0;
-    l->col++;
     return l->input.data[l->index++];
 }
 
-// Check if the next character matches the expected character and advance if it does
-static Bool match(Lexer *l, u8 next) {
-    if (isAtEnd(l)) return FALSE;
-    if (l->input.data[l->index] != next) return FALSE;
-
-    l->index++;
-    return TRUE;
-}
-
 // Peek at the current character without advancing
 static u8 peek(Lexer *l) {
     if (isAtEnd(l)) return 0;
@@ -78,62 +65,105 @@ static u8 peekAhead(Lexer *l, usize n) {
     return l->input.data[l->index + n];
 }
 
+// Advance over a run of characters measured by one of the bulk scanners
+#define SKIP_RUN(l, scanner)                                                                                           \
+    do {                                                                                                               \
+        usize run = (l)->scan->scanner((l)->input.data + (l)->index, (l)->input.len - (l)->index);                     \
+        (l)->index += run;                                                                                             \
+    } while (0)
+
 static void makeIdentifierOrKeyword(Lexer *l) {
     usize start = l->index - 1;
-    usize col = l->col;
 
-    while (isalnum(peek(l)) || peek(l) == '_') advance(l);
+    SKIP_RUN(l, identifier);
     usize end = l->index;
 
-    StringBuilder ident = {0};
-    ErrCode err;
-    if ((err = joinStringSlice(&ident, &l->input, start, end)) != NO_ERR) exit(err);
-    String identString = moveToString(&ident);
-
-    TokenType tokenType = findKeywordOrIdent(identString);
+    // Identifiers refer back into the source and are interned, their text is never copied per token
+    String text = {.data = l->input.data + start, .len = end - start};
+    TokenType tokenType = findKeywordOrIdent(text);
 
-    Token token = (Token){
-        .type = tokenType,
-        .as.stringLiteral = identString,
-        .line = l->line,
-        .col = col,
-    };
+    Token token;
+    if (tokenType == TOK_IDENTIFIER) {
+        Span span = {.offset = (u32)start, .len = (u32)(end - start)};
+        token = makeIdentifierToken(span, internInto(l->interner, text));
+    } else {
+        token = makeSimple(tokenType, start);
+    }
     addToken(l, token);
 }
 
+static Token numberError(NumberStatus status, u32 offset) {
+    switch (status) {
+        case NUMBER_OUT_OF_RANGE: return makeErrorToken("Numeric Literal Out Of Range!", offset);
+        case NUMBER_BAD_DIGIT:    return makeErrorToken("Invalid Digit In Numeric Literal!", offset);
+        case NUMBER_NO_DIGITS:    return makeErrorToken("Numeric Literal Without Digits!", offset);
+        case NUMBER_OK:           break;
+    }
+    UNREACHABLE("numberError called without an error");
+}
+
+// Literals are converted straight from the source bytes, see Number.h
 static void makeNumber(Lexer *l) {
-    Bool isFloat = FALSE;
     usize start = l->index - 1;
-    usize col = l->col;
-
-    while (isdigit(peek(l)) || (peek(l) == '.' && !isFloat)) {
-        if (l->input.data[l->index - 1] == '.') isFloat = TRUE;
-        advance(l);
+    u8 *text = l->input.data;
+
+    u32 base = 10;
+    if (text[start] == '0') {
+        switch (peek(l) | 0x20) {
+            case 'x': base = 16; break;
+            case 'o': base = 8; break;
+            case 'b': base = 2; break;
+        }
     }
-    usize end = l->index;
-
-    StringBuilder number = {0};
-    ErrCode err;
-    if ((err = joinStringSlice(&number, &l->input, start, end)) != NO_ERR) exit(err);
-    joinByte(&number, '\0');
 
-    if (isFloat) {
-        f64 fval = atof((cstr)number.arr);
-        Token floatToken = makeFloatLiteralToken(fval, l->line, col);
-        addToken(l, floatToken);
+    u64 ival;
+    f64 fval;
+    NumberStatus status;
+    Bool isFloat = FALSE;
+    if (base != 10) {
+        // Take the whole alphanumeric run so a stray digit is reported instead of starting a new token
+        advance(l);
+        SKIP_RUN(l, identifier);
+        status = parseInteger((String){.data = text + start + 2, .len = l->index - start - 2}, base, &ival);
     } else {
-        u64 ival = atoll((cstr)number.arr);
-        Token floatToken = makeIntegerLiteralToken(ival, l->line, col);
-        addToken(l, floatToken);
+        isFloat = text[start] == '.';
+        SKIP_RUN(l, digits);
+        if (!isFloat && peek(l) == '.' && isDigitChar(peekAhead(l, 1))) {
+            isFloat = TRUE;
+            advance(l);
+            SKIP_RUN(l, digits);
+        }
+        u8 sign = peekAhead(l, 1);
+        if ((peek(l) | 0x20) == 'e' &&
+            (isDigitChar(sign) || ((sign == '+' || sign == '-') && isDigitChar(peekAhead(l, 2))))) {
+            isFloat = TRUE;
+            advance(l);
+            if (!isDigitChar(sign)) advance(l);
+            SKIP_RUN(l, digits);
+        }
+
+        String literal = {.data = text + start, .len = l->index - start};
+        status = isFloat ? parseFloat(literal, &fval) : parseInteger(literal, 10, &ival);
     }
 
-    free(number.arr);
+    Token token;
+    if (status != NUMBER_OK)
+        token = numberError(status, start);
+    else if (isFloat)
+        token = makeFloatLiteralToken(fval, start);
+    else
+        token = makeIntegerLiteralToken(ival, start);
+    addToken(l, token);
 }
 
-static u8 consumeEscapeChar(Lexer *l) {
+// Only the first bad escape of a literal is reported, which bounds the tokens a single lexeme can emit
+static u8 consumeEscapeChar(Lexer *l, Bool *reported) {
     assert(l->input.data[l->index - 1] == '\\' && "Called consumeEscapeChar without being on '\\'");
     u64 val = 0;
 
+    // Literals never span lines, a trailing backslash leaves the newline for the caller to end the literal on
+    if (peek(l) == '\n') return 0;
+
     u8 c = advance(l);
     switch (c) {
         case 'n':  val = '\n'; break;
@@ -164,20 +194,22 @@ static u8 consumeEscapeChar(Lexer *l) {
     }
 
     if (val > U8_MAX) {
-        StringBuilder err = {0};
-        joinCString(&err, "Escape squence out of u8 range");
-
-        Token token = makeErrorToken(moveToString(&err), l->line, l->col);
-        addToken(l, token);
+        if (!*reported) {
+            Token token = makeErrorToken("Escape squence out of u8 range", l->index - 1);
+            addToken(l, token);
+            *reported = TRUE;
+        }
         return -1;
     }
     return (u8)val;
 }
 
 static void makeString(Lexer *l) {
-    StringBuilder string = {0};
-    usize col = l->col;
+    StringBuilder *string = &l->scratch;
     Token token = {0};
+    Bool escapeReported = FALSE;
+
+    string->len = 0;
 
     while (!isAtEnd(l) && peek(l) != '\n') {
         if (peek(l) == '\"') {
@@ -186,306 +218,440 @@ static void makeString(Lexer *l) {
         }
 
         u8 c = advance(l);
-        if (c == '\\') c = consumeEscapeChar(l);
-        joinByte(&string, c);
+        if (c == '\\') c = consumeEscapeChar(l, &escapeReported);
+        joinByte(string, c);
     }
-    StringBuilder err = {0};
-    joinCString(&err, "Unterminated String Literal!");
-    token = makeErrorToken(moveToString(&err), l->line, col);
+    token = makeErrorToken("Unterminated String Literal!", l->start);
     addToken(l, token);
     return;
 
 terminated:
-    token = makeStringLiteralToken(moveToString(&string), l->line, col);
+    // String literals are pooled in the interner, so tokens never own their contents
+    token = makeStringLiteralToken(internInto(l->interner, (String){.data = string->arr, .len = string->len}),
+                                   l->start);
     addToken(l, token);
 }
 
 static void makeChar(Lexer *l) {
-    usize col = l->col;
-    u8 c = advance(l);
+    Bool escapeReported = FALSE;
+    u8 c = peek(l) == '\n' ? 0 : advance(l);
 
-    if (c == '\\') c = consumeEscapeChar(l);
+    if (c == '\\') c = consumeEscapeChar(l, &escapeReported);
     if (peek(l) != '\'') {
-        StringBuilder err = {0};
-        joinCString(&err, "Unterminated Char Literal!");
-        Token token = makeErrorToken(moveToString(&err), l->line, col);
+        Token token = makeErrorToken("Unterminated Char Literal!", l->start);
         addToken(l, token);
         return;
     }
     advance(l); // Consume temrminating '
 
-    Token token = makeCharLiteralToken(c, l->line, col);
+    Token token = makeCharLiteralToken(c, l->start);
     addToken(l, token);
     return;
 }
 
-#define ADD_SIMPLE(type) addSimpleToken(&lexer, type)
+/**
+ * Punctuators are lexed with maximal munch over a transition table built from PUNCTUATOR_LIST.
+ * State 0 is the start state and is never the target of a transition, so a 0 entry means "no transition".
+ */
+#define PUNCT_MAX_STATES 64
+
+static u8 punctNext[PUNCT_MAX_STATES][128];
+static u8 punctAccept[PUNCT_MAX_STATES]; // TokenType accepted in each state, TOK_UNKNOWN if none
+
+__attribute__((__constructor__)) static void buildPunctuatorTable(void) {
+    usize states = 1;
+    cstr spellings[] = {
+#define X(type, spelling) spelling,
+        PUNCTUATOR_LIST
+#undef X
+    };
+    TokenType types[] = {
+#define X(type, spelling) type,
+        PUNCTUATOR_LIST
+#undef X
+    };
+
+    for (usize i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        usize state = 0;
+        for (cstr c = spellings[i]; *c != '\0'; c++) {
+            if (punctNext[state][(u8)*c] == 0) {
+                ILLEGAL(states == PUNCT_MAX_STATES, "Too many punctuator prefixes, increase PUNCT_MAX_STATES");
+                punctNext[state][(u8)*c] = states++;
+            }
+            state = punctNext[state][(u8)*c];
+        }
+        punctAccept[state] = types[i];
+    }
+}
+
+// Lex the longest punctuator starting at the already consumed character `c`, returns FALSE if none starts with it
+static Bool makePunctuator(Lexer *l, u8 c) {
+    if (c >= 128 || punctNext[0][c] == 0) return FALSE;
+
+    usize start = l->index - 1;
+    usize state = punctNext[0][c];
+    TokenType accepted = punctAccept[state];
+    usize acceptedLen = 1;
+
+    for (usize len = 1; start + len < l->input.len; len++) {
+        u8 next = l->input.data[start + len];
+        if (next >= 128 || punctNext[state][next] == 0) break;
+
+        state = punctNext[state][next];
+        if (punctAccept[state] != TOK_UNKNOWN) {
+            accepted = punctAccept[state];
+            acceptedLen = len + 1;
+        }
+    }
+
+    // Every single character punctuator is accepting, so at least `c` itself matched
+    addToken(l, makeSimple(accepted, start));
+    l->index = start + acceptedLen;
+    return TRUE;
+}
+
+// Lex a single lexeme starting at the current position, blanks and newlines emit no tokens
+static void scanLexeme(Lexer *l) {
+    l->start = l->index;
+    u8 c = advance(l);
+
+    if (isBlankChar(c)) {
+        SKIP_RUN(l, blanks);
+        return;
+    }
+
+    if (isIdentStart(c)) {
+        makeIdentifierOrKeyword(l);
+        return;
+    }
+
+    if (isDigitChar(c) || (c == '.' && isDigitChar(peek(l)))) {
+        makeNumber(l);
+        return;
+    }
+
+    if (c == '\"') {
+        makeString(l);
+        return;
+    }
+
+    if (c == '\'') {
+        makeChar(l);
+        return;
+    }
+
+    if (makePunctuator(l, c)) return;
+
+    switch (c) {
+        case '\n':
+            break;
+        case '\0':
+            addSimpleToken(l, TOK_EOF);
+            break;
+
+        default:
+            addToken(l, makeUnknown(c, l->start));
+            break;
+    }
+}
+
+static Bool initLexer(Lexer *l, const SourceFile *source) {
+    // Token spans store 32 bit offsets into the source
+    if (source->contents.len > U32_MAX) return FALSE;
+
+    *l = (Lexer){0};
+    l->input = source->contents;
+    l->fileName = source->path;
+    l->interner = globalInterner();
+    l->scan = selectScanner();
+    return TRUE;
+}
+
+static void freeLexer(Lexer *l) {
+    free(l->scratch.arr);
+    l->scratch = (StringBuilder){0};
+}
+
+/**********************************************************************************************************************
+ * Parallel Lexing
+ * No token spans a newline, so chunks that start at a line start lex exactly like the same range of the whole file.
+ * Each chunk is lexed into its own list with its own intern table. Afterwards the private symbols are mapped into
+ * the process wide table, and every chunk copies its tokens into place with its symbols fixed up.
+ *********************************************************************************************************************/
+
+// Smaller chunks aren't worth a thread
+#define PARALLEL_LEX_MIN_CHUNK (1024 * 1024)
+
+typedef struct {
+    Lexer lexer;
+    TokensList tokens;
+    InternTable symbols;
+    Symbol *remap;
+    Token *dest;
+} LexChunk;
+
+static void *lexChunk(void *arg) {
+    LexChunk *chunk = arg;
+    while (!isAtEnd(&chunk->lexer)) scanLexeme(&chunk->lexer);
+    return NULL;
+}
+
+static void *placeChunk(void *arg) {
+    LexChunk *chunk = arg;
+    for (usize i = 0; i < chunk->tokens.len; i++) {
+        Token token = chunk->tokens.arr[i];
+        if (token.type == TOK_IDENTIFIER)
+            token.as.identifier.symbol = chunk->remap[token.as.identifier.symbol];
+        else if (token.type == TOK_STRING_LITERAL)
+            token.as.stringLiteral = chunk->remap[token.as.stringLiteral];
+        chunk->dest[i] = token;
+    }
+    return NULL;
+}
+
+// Run `work` on every chunk, one thread each. Chunks whose thread can't be started run on the calling thread.
+static void runChunks(LexChunk *chunks, usize count, void *(*work)(void *)) {
+    pthread_t *threads = calloc(count, sizeof(pthread_t));
+    Bool *started = calloc(count, sizeof(Bool));
+    if (threads == NULL || started == NULL) exit(1);
+
+    for (usize i = 1; i < count; i++) started[i] = pthread_create(&threads[i], NULL, work, &chunks[i]) == 0;
+    work(&chunks[0]);
+    for (usize i = 1; i < count; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            work(&chunks[i]);
+    }
+
+    free(threads);
+    free(started);
+}
 
 /**********************************************************************************************************************
  * Public Lexer API
  *********************************************************************************************************************/
 
-Bool scanFile(TokensList *dest, cstr path) {
-    if (dest == NULL) return NULLPTR_ERR;
-    StringBuilder input = {0};
-    ErrCode err = joinEntireFile(&input, path);
-    if (err != NO_ERR) return err;
+Bool scanSource(TokensList *dest, const SourceFile *source) {
+    if (dest == NULL || source == NULL) return FALSE;
 
-    Lexer lexer = {0};
-    lexer.input = moveToString(&input);
+    Lexer lexer;
+    if (!initLexer(&lexer, source)) return FALSE;
     lexer.tokens = dest;
-    lexer.line = 1;
-    lexer.fileName = (String){ .data = (u8 *)path, .len = strlen(path) };
 
-    while (!isAtEnd(&lexer)) {
-        u8 c = advance(&lexer);
+    while (!isAtEnd(&lexer)) scanLexeme(&lexer);
 
-        if (isalpha(c) || c == '_') {
-            makeIdentifierOrKeyword(&lexer);
-            continue;
-        }
+    freeLexer(&lexer);
+    return !lexer.hasErros;
+}
 
-        if (isdigit(c) || (c == '.' && isdigit(peek(&lexer)))) {
-            makeNumber(&lexer);
-            continue;
-        }
+Bool scanSourceParallel(TokensList *dest, const SourceFile *source, usize threads) {
+    if (dest == NULL || source == NULL) return FALSE;
+    if (source->contents.len > U32_MAX) return FALSE;
+
+    usize len = source->contents.len;
+    usize count = threads;
+    if (count > len / PARALLEL_LEX_MIN_CHUNK) count = len / PARALLEL_LEX_MIN_CHUNK;
+    if (count <= 1) return scanSource(dest, source);
+
+    LexChunk *chunks = calloc(count, sizeof(LexChunk));
+    if (chunks == NULL) exit(1);
+
+    usize start = 0;
+    for (usize i = 0; i < count; i++) {
+        usize end = len * (i + 1) / count;
+        if (end < start) end = start;
+        // Cut right after the next newline
+        u8 *newline = end < len ? memchr(source->contents.data + end, '\n', len - end) : NULL;
+        end = newline != NULL ? (usize)(newline - source->contents.data) + 1 : len;
+
+        LexChunk *chunk = &chunks[i];
+        initLexer(&chunk->lexer, source);
+        chunk->lexer.input.len = end;
+        chunk->lexer.index = start;
+        chunk->lexer.tokens = &chunk->tokens;
+        chunk->lexer.interner = &chunk->symbols;
+        start = end;
+    }
 
-        if (c == '\"') {
-            makeString(&lexer);
-            continue;
-        }
+    runChunks(chunks, count, lexChunk);
 
-        if (c == '\'') {
-            makeChar(&lexer);
-            continue;
-        }
+    Bool hasErrors = FALSE;
+    usize total = dest->len;
+    for (usize i = 0; i < count; i++) {
+        LexChunk *chunk = &chunks[i];
+        total += chunk->tokens.len;
+        hasErrors |= chunk->lexer.hasErros;
 
-        switch (c) {
-            case '\n':
-                lexer.line++;
-                lexer.col = 0;
-            case ' ':
-            case '\r':
-            case '\t':
-                break;
-            // TOK_EQUALS,
-            // TOK_EQUAL_EQUALS,
-            case '=':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_EQUALS_EQUALS);
-                else
-                    ADD_SIMPLE(TOK_EQUALS);
-                break;
-            // TOK_PLUS,
-            // TOK_PLUS_PLUS,
-            // TOK_PLUS_EQUALS,
-            case '+':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_PLUS_EQUALS);
-                else if (match(&lexer, '+'))
-                    ADD_SIMPLE(TOK_PLUS_PLUS);
-                else
-                    ADD_SIMPLE(TOK_PLUS);
-                break;
-            // TOK_MINUS,
-            // TOK_MINUS_MINUS,
-            // TOK_MINUS_EQUALS,
-            // TOK_MINUS_GREATER,
-            case '-':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_MINUS_EQUALS);
-                else if (match(&lexer, '-'))
-                    ADD_SIMPLE(TOK_MINUS_MINUS);
-                else if (match(&lexer, '>'))
-                    ADD_SIMPLE(TOK_MINUS_GREATER);
-                else
-                    ADD_SIMPLE(TOK_MINUS);
-                break;
-            // TOK_STAR,
-            // TOK_STAR_EQUALS,
-            case '*':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_STAR_EQUALS);
-                else
-                    ADD_SIMPLE(TOK_STAR);
-                break;
-            // TOK_SLASH,
-            // TOK_SLASH_EQUALS,
-            case '/':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_SLASH_EQUALS);
-                else
-                    ADD_SIMPLE(TOK_SLASH);
-                break;
-            // TOK_PERCENT,
-            // TOK_PERCENT_EQUALS,
-            case '%':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_PERCENT_EQUALS);
-                else
-                    ADD_SIMPLE(TOK_PERCENT);
-                break;
-            // TOK_BANG,
-            // TOK_BANG_EQUALS,
-            case '!':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_BANG_EQUALS);
-                else
-                    ADD_SIMPLE(TOK_BANG);
-                break;
-            // TOK_LESS,
-            // TOK_LESS_EQUALS,
-            // TOK_LESS_LESS,
-            // TOK_LESS_LESS_EQUALS,
-            case '<':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_LESS_EQUALS);
-                else if (match(&lexer, '<')) {
-                    if (match(&lexer, '='))
-                        ADD_SIMPLE(TOK_LESS_LESS_EQUALS);
-                    else
-                        ADD_SIMPLE(TOK_LESS_LESS);
-                } else
-                    ADD_SIMPLE(TOK_LESS);
-                break;
-            // TOK_GREATER,
-            // TOK_GREATER_EQUALS,
-            // TOK_GREATER_GREATER,
-            // TOK_GREATER_GREATER_EQUALS,
-            case '>':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_GREATER_EQUALS);
-                else if (match(&lexer, '>')) {
-                    if (match(&lexer, '='))
-                        ADD_SIMPLE(TOK_GREATER_GREATER_EQUALS);
-                    else
-                        ADD_SIMPLE(TOK_GREATER_GREATER);
-                } else
-                    ADD_SIMPLE(TOK_GREATER);
-                break;
-            // TOK_AMPERSAND,
-            // TOK_AMPERSAND_AMPERSAND,
-            // TOK_AMPERSAND_EQUALS,
-            case '&':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_AMPERSAND_EQUALS);
-                else if (match(&lexer, '&'))
-                    ADD_SIMPLE(TOK_AMPERSAND_AMPERSAND);
-                else
-                    ADD_SIMPLE(TOK_AMPERSAND);
-                break;
-            // TOK_PIPE,
-            // TOK_PIPE_PIPE,
-            // TOK_PIPE_EQUALS,
-            case '|':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_PIPE_EQUALS);
-                else if (match(&lexer, '|'))
-                    ADD_SIMPLE(TOK_PIPE_PIPE);
-                else
-                    ADD_SIMPLE(TOK_PIPE);
-                break;
-            // TOK_CARET,
-            // TOK_CARET_EQUALS,
-            case '^':
-                if (match(&lexer, '='))
-                    ADD_SIMPLE(TOK_CARET_EQUALS);
-                else
-                    ADD_SIMPLE(TOK_CARET);
-                break;
-            // TOK_TILDE,
-            case '~':
-                ADD_SIMPLE(TOK_TILDE);
-                break;
-            // TOK_LEFT_PAREN,
-            case '(':
-                ADD_SIMPLE(TOK_LEFT_PAREN);
-                break;
-            // TOK_RIGHT_PAREN,
-            case ')':
-                ADD_SIMPLE(TOK_RIGHT_PAREN);
-                break;
-            // TOK_LEFT_BRACE,
-            case '{':
-                ADD_SIMPLE(TOK_LEFT_BRACE);
-                break;
-            // TOK_RIGHT_BRACE,
-            case '}':
-                ADD_SIMPLE(TOK_RIGHT_BRACE);
-                break;
-            // TOK_LEFT_BRACKET,
-            case '[':
-                ADD_SIMPLE(TOK_LEFT_BRACKET);
-                break;
-            // TOK_RIGHT_BRACKET,
-            case ']':
-                ADD_SIMPLE(TOK_RIGHT_BRACKET);
-                break;
-            // TOK_COMMA,
-            case ',':
-                ADD_SIMPLE(TOK_COMMA);
-                break;
-            // TOK_DOT,
-            // TOK_ELLIPSIS,
-            case '.':
-                if (peek(&lexer) == '.' && peekAhead(&lexer, 1) == '.') {
-                    advance(&lexer);
-                    advance(&lexer);
-                    ADD_SIMPLE(TOK_ELLIPSIS);
-                } else
-                    ADD_SIMPLE(TOK_DOT);
-                break;
-            // TOK_SEMICOLON,
-            case ';':
-                ADD_SIMPLE(TOK_SEMICOLON);
-                break;
-            // TOK_COLON,
-            // TOK_COLON_COLON,
-            case ':':
-                if (match(&lexer, ':'))
-                    ADD_SIMPLE(TOK_COLON_COLON);
-                else
-                    ADD_SIMPLE(TOK_COLON);
-                break;
-            // TOK_QUESTION_MARK,
-            case '?':
-                ADD_SIMPLE(TOK_QUESTION_MARK);
-                break;
-            // TOK_AT
-            case '@':
-                ADD_SIMPLE(TOK_AT);
-                break;
-
-            case '\0':
-                ADD_SIMPLE(TOK_EOF);
-                break;
-
-            default:
-                appendSingle(lexer.tokens, makeUnknown(c, lexer.line, lexer.col));
-                break;
+        chunk->remap = malloc((chunk->symbols.entries.len + 1) * sizeof(Symbol));
+        if (chunk->remap == NULL) exit(1);
+        for (Symbol symbol = 0; symbol < chunk->symbols.entries.len; symbol++) {
+            chunk->remap[symbol] = intern(internTableText(&chunk->symbols, symbol));
         }
     }
 
-    free(lexer.input.data);
-    return !lexer.hasErros;
+    if (total > dest->cap) {
+        dest->arr = realloc(dest->arr, total * sizeof(Token));
+        if (dest->arr == NULL) exit(1);
+        dest->cap = total;
+    }
+    for (usize i = 0; i < count; i++) {
+        chunks[i].dest = dest->arr + dest->len;
+        dest->len += chunks[i].tokens.len;
+    }
+
+    runChunks(chunks, count, placeChunk);
+
+    for (usize i = 0; i < count; i++) {
+        freeLexer(&chunks[i].lexer);
+        freeTokensList(&chunks[i].tokens);
+        freeInternTable(&chunks[i].symbols);
+        free(chunks[i].remap);
+    }
+    free(chunks);
+    return !hasErrors;
+}
+
+Bool scanSourceCompact(CompactTokensList *dest, const SourceFile *source) {
+    if (dest == NULL || source == NULL) return FALSE;
+
+    dest->source = source;
+
+    TokenStream stream;
+    if (!openTokenStream(&stream, source)) return FALSE;
+
+    Token token;
+    while ((token = nextToken(&stream)).type != TOK_EOF) appendCompactToken(dest, token);
+
+    Bool ok = !tokenStreamHasErrors(&stream);
+    closeTokenStream(&stream);
+    return ok;
+}
+
+Bool scanFile(TokensList *dest, SourceFile *source, cstr path) {
+    if (dest == NULL || source == NULL) return FALSE;
+    if (openSourceFile(source, path) != NO_ERR) return FALSE;
+
+    return scanSource(dest, source);
 }
 
 void freeTokensList(TokensList *tokens) {
-    for (usize i = 0; i < tokens->len; i++) {
-        Token *tok = &tokens->arr[i];
-        switch (tok->type) {
-            case TOK_IDENTIFIER:
-                free((void *)tok->as.identifier.data);
-                break;
-            case TOK_STRING_LITERAL:
-                free((void *)tok->as.stringLiteral.data);
-                break;
-            default:
-                break;
-        }
-    }
     free(tokens->arr);
     tokens->arr = NULL;
     tokens->len = 0;
     tokens->cap = 0;
 }
+
+/**********************************************************************************************************************
+ * Token Streams
+ *********************************************************************************************************************/
+
+Bool openTokenStream(TokenStream *stream, const SourceFile *source) {
+    if (stream == NULL || source == NULL) return FALSE;
+
+    *stream = (TokenStream){0};
+    stream->source = source;
+    if (!initLexer(&stream->lexer, source)) return FALSE;
+    stream->lexer.ring = &stream->ring;
+    return TRUE;
+}
+
+Bool openTokenStreamAt(TokenStream *stream, const SourceFile *source, u32 offset) {
+    if (!openTokenStream(stream, source)) return FALSE;
+    ILLEGAL(offset > source->contents.len, "Token stream starting past the end of the source");
+    stream->lexer.index = offset;
+    return TRUE;
+}
+
+void openListTokenStream(TokenStream *stream, const SourceFile *source, const TokensList *tokens) {
+    *stream = (TokenStream){0};
+    stream->source = source;
+    stream->list = tokens;
+    // Not every list ends in an EOF token (parallel lexing drops them), so place it at the end of the source
+    stream->eof = makeSimple(TOK_EOF, (u32)source->contents.len);
+}
+
+void openCompactTokenStream(TokenStream *stream, const CompactTokensList *tokens) {
+    *stream = (TokenStream){0};
+    stream->source = tokens->source;
+    stream->compact = tokens;
+    stream->eof = makeSimple(TOK_EOF, (u32)tokens->source->contents.len);
+}
+
+void closeTokenStream(TokenStream *stream) {
+    if (stream->list == NULL && stream->compact == NULL) freeLexer(&stream->lexer);
+}
+
+// Lex until the ring holds more than `n` tokens or the input runs out
+static Bool fillRing(TokenStream *stream, usize n) {
+    Lexer *l = &stream->lexer;
+    while (stream->ring.count <= n && !isAtEnd(l)) scanLexeme(l);
+    if (stream->ring.count > n) return TRUE;
+
+    stream->eof = makeSimple(TOK_EOF, l->index);
+    return FALSE;
+}
+
+Token nextToken(TokenStream *stream) {
+    if (stream->list != NULL) {
+        if (stream->listIndex == stream->list->len) return stream->eof;
+        return stream->list->arr[stream->listIndex++];
+    }
+
+    if (stream->compact != NULL) {
+        const CompactTokensList *tokens = stream->compact;
+        if (stream->listIndex == tokens->len) return stream->eof;
+
+        usize index = stream->listIndex++;
+        Token token = compactToken(tokens, index, stream->payloadIndex);
+        if (tokenHasPayload(tokens->types[index])) stream->payloadIndex++;
+        return token;
+    }
+
+    if (!fillRing(stream, 0)) return stream->eof;
+    Token token = stream->ring.slots[stream->ring.head];
+    stream->ring.head = (stream->ring.head + 1) & (TOKEN_RING_SIZE - 1);
+    stream->ring.count--;
+    return token;
+}
+
+Token peekToken(TokenStream *stream, usize n) {
+    ILLEGAL(n >= TOKEN_STREAM_MAX_LOOKAHEAD, "Peeking past the token stream lookahead");
+
+    if (stream->list != NULL) {
+        if (stream->listIndex + n >= stream->list->len) return stream->eof;
+        return stream->list->arr[stream->listIndex + n];
+    }
+
+    if (stream->compact != NULL) {
+        const CompactTokensList *tokens = stream->compact;
+        if (stream->listIndex + n >= tokens->len) return stream->eof;
+
+        usize payloadIndex = stream->payloadIndex;
+        for (usize i = stream->listIndex; i < stream->listIndex + n; i++) {
+            if (tokenHasPayload(tokens->types[i])) payloadIndex++;
+        }
+        return compactToken(tokens, stream->listIndex + n, payloadIndex);
+    }
+
+    if (!fillRing(stream, n)) return stream->eof;
+    return stream->ring.slots[(stream->ring.head + n) & (TOKEN_RING_SIZE - 1)];
+}
+
+TokenType peekTokenType(TokenStream *stream, usize n) {
+    if (stream->compact != NULL) {
+        if (stream->listIndex + n >= stream->compact->len) return TOK_EOF;
+        return stream->compact->types[stream->listIndex + n];
+    }
+
+    if (stream->list != NULL) {
+        if (stream->listIndex + n >= stream->list->len) return TOK_EOF;
+        return stream->list->arr[stream->listIndex + n].type;
+    }
+
+    return peekToken(stream, n).type;
+}
+
+Bool tokenStreamHasErrors(TokenStream *stream) {
+    return stream->list == NULL && stream->compact == NULL && stream->lexer.hasErros;
+}
@@ -0,0 +1,77 @@
+#include "Lower.h"
+
+static void lowerType(Arena *arena, Type *type) {
+    while (type != NULL) {
+        switch (type->kind) {
+            case TYPE_SIMPLE:
+                return;
+            case TYPE_POINTER:
+                type = type->as.pointer;
+                break;
+            case TYPE_ARRAY:
+                lowerExpr(arena, type->as.array.size);
+                type = type->as.array.inner;
+                break;
+        }
+    }
+}
+
+// Rewrites a node once all of its children have been lowered
+static Bool lowerStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    Arena *arena = ctx;
+    // Walks hand out const nodes, this pass owns the tree it rewrites
+    Expr *root = (Expr *)node.node;
+
+    const Expr *next = exprChild(root, step);
+    if (next != NULL) {
+        *child = (WalkNode){.kind = WALK_EXPR, .node = next};
+        return TRUE;
+    }
+
+    switch (root->type) {
+        case EXPR_COMPOUND_ASSIGN: {
+            CompoundAssignExpr assign = root->as.compoundAssign;
+            Expr *value = makeBinaryExpr(arena, compoundAssignOperator(assign.op), assign.target, assign.value);
+            root->type = EXPR_BINARY;
+            root->as.binary = (BinaryExpr){.op = TOK_EQUALS, .lhs = assign.target, .rhs = value};
+            break;
+        }
+        case EXPR_INCREMENT: {
+            IncrementExpr increment = root->as.increment;
+            if (!increment.isPrefix) break;
+
+            Token oneToken = {.type = TOK_INTEGER_LITERAL, .offset = increment.offset, .as.integerLiteral = 1};
+            TokenType op = increment.op == TOK_PLUS_PLUS ? TOK_PLUS : TOK_MINUS;
+            Expr *value = makeBinaryExpr(arena, op, increment.target, makePrimaryExpr(arena, oneToken));
+            root->type = EXPR_BINARY;
+            root->as.binary = (BinaryExpr){.op = TOK_EQUALS, .lhs = increment.target, .rhs = value};
+            break;
+        }
+        default:
+            break;
+    }
+    return FALSE;
+}
+
+/**********************************************************************************************************************
+ * Public Lowering API
+ *********************************************************************************************************************/
+
+void lowerExpr(Arena *arena, Expr *root) {
+    if (root == NULL) return;
+    walk((WalkNode){.kind = WALK_EXPR, .node = root}, lowerStep, arena);
+}
+
+void lowerStmtList(Arena *arena, StmtList list) {
+    for (usize i = 0; i < list.len; i++) {
+        Stmt *stmt = list.arr[i];
+        switch (stmt->type) {
+            case STMT_DECLARATION:
+                lowerType(arena, stmt->as.declaration.type);
+                lowerExpr(arena, stmt->as.declaration.initializer);
+                break;
+            case STMT_ENUM:
+                break;
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#include "Number.h"
+#include "Scan.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest power of ten whose f64 value is exact
+#define MAX_EXACT_POWER_OF_10 22
+// Largest integer every smaller integer of which is an exact f64
+#define MAX_EXACT_MANTISSA (1ull << 53)
+// Decimal digits that always fit a u64
+#define MAX_SAFE_DIGITS 19
+
+static const f64 exactPowersOf10[MAX_EXACT_POWER_OF_10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Value of a digit in any base up to 36, bases reject anything at or above them
+static inline u8 digitValue(u8 c) {
+    if ('0' <= c && c <= '9') return c - '0';
+    c |= 0x20; // Lower case
+    if ('a' <= c && c <= 'z') return c - 'a' + 10;
+    return U8_MAX;
+}
+
+/**********************************************************************************************************************
+ * Public Number API
+ *********************************************************************************************************************/
+
+NumberStatus parseInteger(String digits, u32 base, u64 *dest) {
+    if (digits.len == 0) return NUMBER_NO_DIGITS;
+
+    u64 value = 0;
+    usize i = 0;
+    if (base == 10) {
+        // The first 19 decimal digits can't overflow, only the tail needs checking
+        usize safe = digits.len < MAX_SAFE_DIGITS ? digits.len : MAX_SAFE_DIGITS;
+        for (; i < safe; i++) {
+            u8 digit = digitValue(digits.data[i]);
+            if (digit >= base) return NUMBER_BAD_DIGIT;
+            value = value * 10 + digit;
+        }
+    }
+
+    // Keep going after an overflow, a bad digit is the more useful diagnostic
+    NumberStatus status = NUMBER_OK;
+    for (; i < digits.len; i++) {
+        u8 digit = digitValue(digits.data[i]);
+        if (digit >= base) return NUMBER_BAD_DIGIT;
+        if (__builtin_mul_overflow(value, base, &value) || __builtin_add_overflow(value, digit, &value))
+            status = NUMBER_OUT_OF_RANGE;
+    }
+
+    *dest = value;
+    return status;
+}
+
+NumberStatus parseFloat(String text, f64 *dest) {
+    const u8 *p = text.data;
+    const u8 *end = text.data + text.len;
+
+    // Decompose into mantissa * 10^exponent, keeping the first 19 significant digits
+    u64 mantissa = 0;
+    i64 exponent = 0;
+    usize significant = 0;
+    Bool truncated = FALSE;
+    Bool anyDigits = FALSE;
+
+    for (; p < end && isDigitChar(*p); p++) {
+        anyDigits = TRUE;
+        if (significant < MAX_SAFE_DIGITS) {
+            mantissa = mantissa * 10 + (*p - '0');
+            significant += mantissa != 0;
+        } else {
+            truncated |= *p != '0';
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && isDigitChar(*p); p++) {
+            anyDigits = TRUE;
+            if (significant < MAX_SAFE_DIGITS) {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if (!anyDigits) return NUMBER_NO_DIGITS;
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        Bool negative = p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        if (p == end || !isDigitChar(*p)) return NUMBER_NO_DIGITS;
+
+        // Saturate, anything this large is out of range or zero either way
+        i64 written = 0;
+        for (; p < end && isDigitChar(*p); p++) {
+            if (written < 100000) written = written * 10 + (*p - '0');
+        }
+        exponent += negative ? -written : written;
+    }
+    if (p != end) return NUMBER_BAD_DIGIT;
+
+    // Fast path: both operands are exact, so the single IEEE operation rounds correctly
+    if (!truncated && mantissa <= MAX_EXACT_MANTISSA && -MAX_EXACT_POWER_OF_10 <= exponent &&
+        exponent <= MAX_EXACT_POWER_OF_10) {
+        f64 value = (f64)mantissa;
+        *dest = exponent < 0 ? value / exactPowersOf10[-exponent] : value * exactPowersOf10[exponent];
+        return NUMBER_OK;
+    }
+
+    // Slow path for long mantissas and large exponents. strtod needs a terminator the source doesn't have, so copy
+    // onto the stack, only pathological literals need the heap.
+    char buffer[128];
+    char *copy = text.len < sizeof(buffer) ? buffer : malloc(text.len + 1);
+    if (copy == NULL) exit(1);
+    memcpy(copy, text.data, text.len);
+    copy[text.len] = '\0';
+
+    f64 value = strtod(copy, NULL);
+    if (copy != buffer) free(copy);
+
+    *dest = value;
+    return isinf(value) ? NUMBER_OUT_OF_RANGE : NUMBER_OK;
+}
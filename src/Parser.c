@@ -1,47 +1,70 @@
 #include "Parser.h"
+#include "TokenClasses.h"
 #include <libk/Errors.h>
-#include <stdarg.h>
+#include <pthread.h>
+#include <setjmp.h>
 #include <stdio.h>
+#include <string.h>
 
 typedef struct {
-    TokensList input;
+    Arena *arena;
+    TokenStream *input;
+    Token previous;
     String fileName;
-    usize index;
     Bool hasErrors;
+    Bool stop; // The error limit was reached
+    Diagnostics *diagnostics;
+    jmp_buf recover; // Set at the start of every top level statement, see declaration
+    // Scratch space reused across statements, so nothing is left on the heap when an error unwinds the parser
+    TokensList entries; // Enum entries being collected
+    struct {
+        LIST_FIELDS(Expr *);
+    } args; // Arguments of the calls being parsed, innermost call on top
 } Parser;
 
-static Bool isAtEnd(Parser *p) { return p->index == p->input.len; }
+static Bool isAtEnd(Parser *p) { return peekTokenType(p->input, 0) == TOK_EOF; }
 
-static Token previous(Parser *p) { return p->input.arr[p->index - 1]; }
+static Token previous(Parser *p) { return p->previous; }
 
-static Bool match(Parser *p, usize count, ...) {
-    if (isAtEnd(p)) return FALSE;
-
-    va_list args;
-    va_start(args, count);
-    for (usize i = 0; i < count; i++) {
-        if (p->input.arr[p->index].type == va_arg(args, TokenType)) {
-            va_end(args);
-            p->index++;
-            return TRUE;
-        }
-    }
-    va_end(args);
-    return FALSE;
+// Consume the next token if it is `type`
+static Bool match(Parser *p, TokenType type) {
+    if (peekTokenType(p->input, 0) != type) return FALSE;
+    p->previous = nextToken(p->input);
+    return TRUE;
 }
 
-static Token peek(Parser *p) {
-    if (isAtEnd(p)) return (Token){0};
-    return p->input.arr[p->index];
+// Consume the next token if `matches`, the result of a test on it
+static inline Bool consumeIf(Parser *p, Bool matches) {
+    if (!matches) return FALSE;
+    p->previous = nextToken(p->input);
+    return TRUE;
 }
 
+// Consume the next token if it is in the token class `list`, see TokenClasses.h
+#define MATCH_CLASS(p, list) consumeIf((p), TOKEN_CLASS_HAS(list, peekTokenType((p)->input, 0)))
+
+static Token peek(Parser *p) { return peekToken(p->input, 0); }
+
+// Record the error and unwind to the enclosing top level statement, which resynchronizes
 __attribute__((__noreturn__)) static void parseError(Parser *p, cstr msg) {
-    fprintf(stderr, "[%zu:%zu]: %s\n", peek(p).line, peek(p).col, msg);
-    abort();
+    Token at = peek(p);
+    // Lexing errors reach the parser as tokens, their message says more than what the parser expected
+    if (at.type == TOK_ERROR) msg = at.as.error;
+    p->hasErrors = TRUE;
+    if (!reportDiagnostic(p->diagnostics, at.offset, msg)) p->stop = TRUE;
+    longjmp(p->recover, 1);
+}
+
+// Skip past the next ';' or '}', where the following statement most likely starts
+static void synchronize(Parser *p) {
+    while (!isAtEnd(p)) {
+        TokenType type = nextToken(p->input).type;
+        if (type == TOK_SEMICOLON || type == TOK_RIGHT_BRACE) return;
+    }
 }
 
 static void expect(Parser *p, TokenType expected, cstr msg) {
-    if (match(p, 1, expected)) return;
+    if (match(p, expected)) return;
     parseError(p, msg);
 }
 
@@ -49,203 +72,101 @@ static void expect(Parser *p, TokenType expected, cstr msg) {
  * Expression Parsing
  *****************************************************************************/
 
-static Expr *expression(Parser *p);
-static Expr *comma(Parser *p);
-static Expr *conditional(Parser *p);
-static Expr *logicalOr(Parser *p);
-static Expr *logicalAnd(Parser *p);
-static Expr *bitwiseOr(Parser *p);
-static Expr *bitwiseXor(Parser *p);
-static Expr *bitwiseAnd(Parser *p);
-static Expr *assignment(Parser *p);
-static Expr *equality(Parser *p);
-static Expr *relational(Parser *p);
-static Expr *shift(Parser *p);
-static Expr *additive(Parser *p);
-static Expr *multiplicative(Parser *p);
+/**
+ * Binary, assignment and conditional operators are parsed by precedence climbing over a table keyed on the operator
+ * token, so parsing an operand costs the same regardless of how many precedence levels the grammar has. The levels
+ * follow grammar.bnf, from loosest to tightest binding.
+ */
+typedef enum {
+    PREC_NONE, // Not a binary operator
+    PREC_COMMA,
+    PREC_ASSIGNMENT,
+    PREC_CONDITIONAL,
+    PREC_LOGICAL_OR,
+    PREC_LOGICAL_AND,
+    PREC_BITWISE_OR,
+    PREC_BITWISE_XOR,
+    PREC_BITWISE_AND,
+    PREC_EQUALITY,
+    PREC_RELATIONAL,
+    PREC_SHIFT,
+    PREC_ADDITIVE,
+    PREC_MULTIPLICATIVE,
+} Precedence;
+
+#define BINARY_OPERATOR_LIST                                                                                           \
+    X(TOK_COMMA,                 PREC_COMMA)                                                                           \
+    X(TOK_EQUALS,                PREC_ASSIGNMENT)                                                                      \
+    X(TOK_QUESTION_MARK,         PREC_CONDITIONAL)                                                                     \
+    X(TOK_PIPE_PIPE,             PREC_LOGICAL_OR)                                                                      \
+    X(TOK_AMPERSAND_AMPERSAND,   PREC_LOGICAL_AND)                                                                     \
+    X(TOK_PIPE,                  PREC_BITWISE_OR)                                                                      \
+    X(TOK_CARET,                 PREC_BITWISE_XOR)                                                                     \
+    X(TOK_AMPERSAND,             PREC_BITWISE_AND)                                                                     \
+    X(TOK_EQUALS_EQUALS,         PREC_EQUALITY)                                                                        \
+    X(TOK_BANG_EQUALS,           PREC_EQUALITY)                                                                        \
+    X(TOK_LESS,                  PREC_RELATIONAL)                                                                      \
+    X(TOK_GREATER,               PREC_RELATIONAL)                                                                      \
+    X(TOK_LESS_EQUALS,           PREC_RELATIONAL)                                                                      \
+    X(TOK_GREATER_EQUALS,        PREC_RELATIONAL)                                                                      \
+    X(TOK_LESS_LESS,             PREC_SHIFT)                                                                           \
+    X(TOK_GREATER_GREATER,       PREC_SHIFT)                                                                           \
+    X(TOK_PLUS,                  PREC_ADDITIVE)                                                                        \
+    X(TOK_MINUS,                 PREC_ADDITIVE)                                                                        \
+    X(TOK_STAR,                  PREC_MULTIPLICATIVE)                                                                  \
+    X(TOK_SLASH,                 PREC_MULTIPLICATIVE)                                                                  \
+    X(TOK_PERCENT,               PREC_MULTIPLICATIVE)
+
+static const u8 binaryPrecedence[TOKEN_TYPE_COUNT] = {
+#define X(op, precedence) [op] = precedence,
+    BINARY_OPERATOR_LIST
+#undef X
+#define X(assignOp, op) [assignOp] = PREC_ASSIGNMENT,
+    COMPOUND_ASSIGNMENT_LIST
+#undef X
+};
+
+static Expr *binary(Parser *p, Precedence minPrecedence);
 static Expr *unary(Parser *p);
 static Expr *postfix(Parser *p);
 static Expr *primary(Parser *p);
 
 //*****************************************************************************
 
-static Expr *expression(Parser *p) { return comma(p); }
-
-// comma := assignment {',' assignment}*
-static Expr *comma(Parser *p) {
-    Expr *expr = assignment(p);
-
-    while (match(p, 1, TOK_COMMA)) {
-        Expr *rhs = assignment(p);
-        expr = makeBinaryExpr(TOK_COMMA, expr, rhs);
-    }
-
-    return expr;
-}
-
-#define DESUGAR_ASSIGNMENT(op)                                                                                         \
-    else if (match(p, 1, op##_EQUALS)) {                                                                               \
-        Expr *rhs = assignment(p);                                                                                     \
-        expr = makeBinaryExpr(TOK_EQUALS, expr, makeBinaryExpr(op, cloneExpr(expr), rhs));                             \
-    }
-
-// assignment := conditional {('=' | '+=' | '-=' | '*=' | '/=' | '%=' | '&=' | '^=' | '|=' | '<<=' | '>>=') assignment}*
-static Expr *assignment(Parser *p) {
-    Expr *expr = conditional(p);
-
-    if (match(p, 1, TOK_EQUALS)) {
-        Expr *rhs = assignment(p);
-        expr = makeBinaryExpr(TOK_EQUALS, expr, rhs);
-    }
-    // Desugar compound assignments like a += b into a = a + b
-    DESUGAR_ASSIGNMENT(TOK_PLUS)
-    DESUGAR_ASSIGNMENT(TOK_MINUS)
-    DESUGAR_ASSIGNMENT(TOK_STAR)
-    DESUGAR_ASSIGNMENT(TOK_SLASH)
-    DESUGAR_ASSIGNMENT(TOK_PERCENT)
-    DESUGAR_ASSIGNMENT(TOK_AMPERSAND)
-    DESUGAR_ASSIGNMENT(TOK_CARET)
-    DESUGAR_ASSIGNMENT(TOK_PIPE)
-    DESUGAR_ASSIGNMENT(TOK_LESS_LESS)
-    DESUGAR_ASSIGNMENT(TOK_GREATER_GREATER)
-
-    return expr;
-}
-
-// conditional := logicalOr {'?' expression ':' conditional}?
-static Expr *conditional(Parser *p) {
-    Expr *expr = logicalOr(p);
-
-    if (match(p, 1, TOK_QUESTION_MARK)) {
-        Expr *trueBranch = expression(p);
-        expect(p, TOK_COLON, "Expected \':\'");
-        Expr *falseBranch = conditional(p);
-        expr = makeConditionalExpr(expr, trueBranch, falseBranch);
-    }
-
-    return expr;
-}
-
-// logicalOr := logicalAnd {'||' logicalAnd}*
-static Expr *logicalOr(Parser *p) {
-    Expr *expr = logicalAnd(p);
-
-    while (match(p, 1, TOK_PIPE_PIPE)) {
-        Expr *rhs = logicalAnd(p);
-        expr = makeBinaryExpr(TOK_PIPE_PIPE, expr, rhs);
-    }
-
-    return expr;
-}
-
-// logicalAnd := bitwiseOr {'&&' bitwiseOr}*
-static Expr *logicalAnd(Parser *p) {
-    Expr *expr = bitwiseOr(p);
-
-    while (match(p, 1, TOK_AMPERSAND_AMPERSAND)) {
-        Expr *rhs = bitwiseOr(p);
-        expr = makeBinaryExpr(TOK_AMPERSAND_AMPERSAND, expr, rhs);
-    }
-
-    return expr;
-}
-
-// bitwiseOr := bitwiseXor {'|' bitwiseXor}*
-static Expr *bitwiseOr(Parser *p) {
-    Expr *expr = bitwiseXor(p);
-
-    while (match(p, 1, TOK_PIPE)) {
-        Expr *rhs = bitwiseXor(p);
-        expr = makeBinaryExpr(TOK_PIPE, expr, rhs);
-    }
-
-    return expr;
-}
-
-// bitwiseXor := bitwiseAnd {'^' bitwiseAnd}*
-static Expr *bitwiseXor(Parser *p) {
-    Expr *expr = bitwiseAnd(p);
-
-    while (match(p, 1, TOK_CARET)) {
-        Expr *rhs = bitwiseAnd(p);
-        expr = makeBinaryExpr(TOK_CARET, expr, rhs);
-    }
-
-    return expr;
-}
-
-// bitwiseAnd := equality {'&' equality}*
-static Expr *bitwiseAnd(Parser *p) {
-    Expr *expr = equality(p);
-
-    while (match(p, 1, TOK_AMPERSAND)) {
-        Expr *rhs = equality(p);
-        expr = makeBinaryExpr(TOK_AMPERSAND, expr, rhs);
-    }
-
-    return expr;
-}
-
-// equality := relational {('==' | '!=') relational}*
-static Expr *equality(Parser *p) {
-    Expr *expr = relational(p);
-
-    while (match(p, 2, TOK_EQUALS_EQUALS, TOK_BANG_EQUALS)) {
-        TokenType op = previous(p).type;
-        Expr *rhs = relational(p);
-        expr = makeBinaryExpr(op, expr, rhs);
-    }
-
-    return expr;
-}
-
-// relational := shift {('<' | '>' | '<=' | '>=') shift}*
-static Expr *relational(Parser *p) {
-    Expr *expr = shift(p);
-
-    while (match(p, 4, TOK_LESS, TOK_GREATER, TOK_LESS_EQUALS, TOK_GREATER_EQUALS)) {
-        TokenType op = previous(p).type;
-        Expr *rhs = shift(p);
-        expr = makeBinaryExpr(op, expr, rhs);
-    }
-
-    return expr;
-}
-
-// shift := additive {('<<' | '>>') additive}*
-static Expr *shift(Parser *p) {
-    Expr *expr = additive(p);
-
-    while (match(p, 2, TOK_LESS_LESS, TOK_GREATER_GREATER)) {
-        TokenType op = previous(p).type;
-        Expr *rhs = additive(p);
-        expr = makeBinaryExpr(op, expr, rhs);
-    }
-
-    return expr;
-}
-
-// additive := multiplicative {('+' | '-') multiplicative}*
-static Expr *additive(Parser *p) {
-    Expr *expr = multiplicative(p);
+// expression := comma
+static Expr *expression(Parser *p) { return binary(p, PREC_COMMA); }
 
-    while (match(p, 2, TOK_PLUS, TOK_MINUS)) {
-        TokenType op = previous(p).type;
-        Expr *rhs = multiplicative(p);
-        expr = makeBinaryExpr(op, expr, rhs);
-    }
+// assignment := conditional {('=' | '+=' | '-=' | '*=' | '/=' | '%=' | '&=' | '^=' | '|=' | '<<=' | '>>=') assignment}?
+static Expr *assignment(Parser *p) { return binary(p, PREC_ASSIGNMENT); }
 
-    return expr;
-}
-
-// multiplicative := unary {('*' | '/' | '%') unary}*
-static Expr *multiplicative(Parser *p) {
+// Parse an expression whose operators all bind at least as tight as `minPrecedence`. Operators are left associative
+// except for assignments and conditionals, whose right operand is parsed at their own level.
+static Expr *binary(Parser *p, Precedence minPrecedence) {
     Expr *expr = unary(p);
 
-    while (match(p, 3, TOK_STAR, TOK_SLASH, TOK_PERCENT)) {
-        TokenType op = previous(p).type;
-        Expr *rhs = unary(p);
-        expr = makeBinaryExpr(op, expr, rhs);
+    while (TRUE) {
+        TokenType op = peekTokenType(p->input, 0);
+        Precedence precedence = binaryPrecedence[op];
+        if (precedence == PREC_NONE || precedence < minPrecedence) break;
+        p->previous = nextToken(p->input);
+
+        if (precedence == PREC_CONDITIONAL) {
+            // conditional := logical_or {'?' expression ':' conditional}?
+            Expr *trueBranch = expression(p);
+            expect(p, TOK_COLON, "Expected \':\'");
+            Expr *falseBranch = binary(p, PREC_CONDITIONAL);
+            expr = makeConditionalExpr(p->arena, expr, trueBranch, falseBranch);
+        } else if (precedence == PREC_ASSIGNMENT) {
+            Expr *rhs = binary(p, PREC_ASSIGNMENT);
+            if (op == TOK_EQUALS) {
+                expr = makeBinaryExpr(p->arena, TOK_EQUALS, expr, rhs);
+            } else {
+                expr = makeCompoundAssignExpr(p->arena, op, expr, rhs);
+            }
+        } else {
+            Expr *rhs = binary(p, precedence + 1);
+            expr = makeBinaryExpr(p->arena, op, expr, rhs);
+        }
     }
 
     return expr;
@@ -254,24 +175,16 @@ static Expr *multiplicative(Parser *p) {
 // unary := ('&' | '*' | '+' | '-' | '~' | '!' | '++' | '--') unary
 //        | postfix
 static Expr *unary(Parser *p) {
-    // Desugar ++x into x = x + 1 and --x into x = x - 1
-    if (match(p, 2, TOK_PLUS_PLUS, TOK_MINUS_MINUS)) {
-        TokenType op = previous(p).type == TOK_PLUS_PLUS ? TOK_PLUS : TOK_MINUS;
+    if (MATCH_CLASS(p, INCREMENT_OPS)) {
+        Token op = previous(p);
         Expr *inner = unary(p);
-        Token oneToken = (Token){
-            .type = TOK_INTEGER_LITERAL,
-            .as.integerLiteral = 1,
-            .col = previous(p).col,
-            .line = previous(p).line,
-        };
-        Expr *oneExpr = makePrimaryExpr(oneToken);
-        return makeBinaryExpr(TOK_EQUALS, inner, makeBinaryExpr(op, inner, oneExpr));
+        return makeIncrementExpr(p->arena, op, TRUE, inner);
     }
 
-    if (match(p, 6, TOK_AMPERSAND, TOK_STAR, TOK_PLUS, TOK_MINUS, TOK_TILDE, TOK_BANG)) {
+    if (MATCH_CLASS(p, UNARY_OPS)) {
         TokenType op = previous(p).type;
         Expr *inner = unary(p);
-        return makeUnaryExpr(op, inner);
+        return makeUnaryExpr(p->arena, op, inner);
     }
 
     return postfix(p);
@@ -286,27 +199,33 @@ static Expr *postfix(Parser *p) {
     Expr *expr = primary(p);
 
     while (TRUE) {
-        if (match(p, 1, TOK_LEFT_BRACKET)) {
+        if (match(p, TOK_LEFT_BRACKET)) {
             Expr *index = expression(p);
             expect(p, TOK_RIGHT_BRACKET, "Missing ']' at the end of indexing");
-            expr = makeIndexExpr(expr, index);
-        } else if (match(p, 1, TOK_LEFT_PAREN)) {
-            ArgsList args = {0};
-            if (!match(p, 1, TOK_RIGHT_PAREN)) {
+            expr = makeIndexExpr(p->arena, expr, index);
+        } else if (match(p, TOK_LEFT_PAREN)) {
+            usize base = p->args.len;
+            if (!match(p, TOK_RIGHT_PAREN)) {
                 do {
                     Expr *arg = assignment(p);
-                    appendSingle(&args, arg);
-                } while (match(p, 1, TOK_COMMA));
+                    appendSingle(&p->args, arg);
+                } while (match(p, TOK_COMMA));
                 expect(p, TOK_RIGHT_PAREN, "Missing ')' at the end of function call");
             }
-            expr = makeFuncCallExpr(expr, args);
-        } else if (match(p, 2, TOK_DOT, TOK_MINUS_GREATER)) {
+            usize count = p->args.len - base;
+            ArgsList args = {
+                .arr = arenaCopy(p->arena, ARENA_LIST, p->args.arr + base, count * sizeof(Expr *)),
+                .len = count,
+                .cap = count,
+            };
+            p->args.len = base;
+            expr = makeFuncCallExpr(p->arena, expr, args);
+        } else if (MATCH_CLASS(p, MEMBER_OPS)) {
             TokenType op = previous(p).type;
             expect(p, TOK_IDENTIFIER, "Expected member");
-            expr = makeMemberExpr(op, expr, previous(p));
-        } else if (match(p, 2, TOK_PLUS_PLUS, TOK_MINUS_MINUS)) {
-            TokenType op = previous(p).type;
-            expr = makeUnaryExpr(op, expr);
+            expr = makeMemberExpr(p->arena, op, expr, previous(p));
+        } else if (MATCH_CLASS(p, INCREMENT_OPS)) {
+            expr = makeIncrementExpr(p->arena, previous(p), FALSE, expr);
         } else {
             break;
         }
@@ -317,13 +236,13 @@ static Expr *postfix(Parser *p) {
 
 // primary := INTEGER_LITERAL | FLOAT_LITERAL | CHAR_LITERAL | STRING_LITERAL | IDENTIFIER | '(' expression ')'
 static Expr *primary(Parser *p) {
-    if (match(p, 5, TOK_INTEGER_LITERAL, TOK_FLOAT_LITERAL, TOK_CHAR_LITERAL, TOK_STRING_LITERAL, TOK_IDENTIFIER)) {
+    if (MATCH_CLASS(p, PRIMARY_TOKENS)) {
         Token prev = previous(p);
-        return makePrimaryExpr(prev);
-    } else if (match(p, 1, TOK_LEFT_PAREN)) {
+        return makePrimaryExpr(p->arena, prev);
+    } else if (match(p, TOK_LEFT_PAREN)) {
         Expr *inner = expression(p);
         expect(p, TOK_RIGHT_PAREN, "Expected \')\'");
-        return makeGroupingExpr(inner);
+        return makeGroupingExpr(p->arena, inner);
     }
 
     parseError(p, "Expected expression");
@@ -333,23 +252,30 @@ static Expr *primary(Parser *p) {
  * Statements Parsing
  *****************************************************************************/
 
+static Stmt *declaration(Parser *p);
 static Stmt *statement(Parser *p);
 static Stmt *variable(Parser *p);
 static Stmt *enumStmt(Parser *p);
 
 //*****************************************************************************
 
+// A top level statement, or NULL if it had errors. Everything parsed below this point reports errors through
+// parseError, which jumps back here.
+static Stmt *declaration(Parser *p) {
+    if (setjmp(p->recover) != 0) {
+        p->args.len = 0;
+        synchronize(p);
+        return NULL;
+    }
+    return statement(p);
+}
+
 static Stmt *statement(Parser *p) {
-    while (match(p, 1, TOK_SEMICOLON));
+    while (match(p, TOK_SEMICOLON));
 
-    TokenType next = peek(p).type;
-    if (next == TOK_CONST || next == TOK_STATIC || next == TOK_EXTERN || next == TOK_U8 || next == TOK_U16 ||
-        next == TOK_U32 || next == TOK_U64 || next == TOK_I8 || next == TOK_I16 || next == TOK_I32 || next == TOK_I64 ||
-        next == TOK_F32 || next == TOK_F64 || next == TOK_BOOL || next == TOK_VOID || next == TOK_IDENTIFIER) {
-        return variable(p);
-    }
+    if (TOKEN_CLASS_HAS(DECLARATION_START, peekTokenType(p->input, 0))) return variable(p);
 
-    if (match(p, 1, TOK_ENUM))
+    if (match(p, TOK_ENUM))
         return enumStmt(p);
 
     parseError(p, "Expected statement");
@@ -358,84 +284,244 @@ static Stmt *statement(Parser *p) {
 // variable := ('extern' | 'static')? 'const'? type {'*' const?}* identifier {'[' expression? ]'}? ('=' expression)? ';'
 static Stmt *variable(Parser *p) {
     StorageClass storageClass = STORAGE_NONE;
-    if (match(p, 2, TOK_EXTERN, TOK_STATIC)) {
+    if (MATCH_CLASS(p, STORAGE_CLASSES)) {
         storageClass = previous(p).type == TOK_EXTERN ? STORAGE_EXTERN : STORAGE_STATIC;
     }
 
-    Bool isConst = match(p, 1, TOK_CONST);
+    Bool isConst = match(p, TOK_CONST);
 
-    if (!match(p, 13, TOK_U8, TOK_U16, TOK_U32, TOK_U64, TOK_I8, TOK_I16, TOK_I32, TOK_I64, TOK_F32, TOK_F64, TOK_BOOL,
-               TOK_VOID, TOK_IDENTIFIER)) {
+    if (!MATCH_CLASS(p, TYPE_NAMES)) {
         parseError(p, "Expected type");
     }
 
-    Type *type = makePrimitiveType(previous(p), isConst);
+    Type *type = makePrimitiveType(p->arena, previous(p), isConst);
 
-    while (match(p, 1, TOK_STAR)) {
-        Bool pointerIsConst = match(p, 1, TOK_CONST);
-        type = makePointerType(type, pointerIsConst);
+    while (match(p, TOK_STAR)) {
+        Bool pointerIsConst = match(p, TOK_CONST);
+        type = makePointerType(p->arena, type, pointerIsConst);
     }
 
     expect(p, TOK_IDENTIFIER, "Expected variable name");
     Token identifier = previous(p);
 
-    if (match(p, 1, TOK_LEFT_BRACKET)) {
+    if (match(p, TOK_LEFT_BRACKET)) {
         Expr *size = NULL;
-        if (!match(p, 1, TOK_RIGHT_BRACKET)) {
+        if (!match(p, TOK_RIGHT_BRACKET)) {
             size = expression(p);
             expect(p, TOK_RIGHT_BRACKET, "Expected ']' at the end of array type");
         }
-        type = makeArrayType(type, size, FALSE);
+        type = makeArrayType(p->arena, type, size, FALSE);
     }
 
     Expr *initializer = NULL;
-    if (match(p, 1, TOK_EQUALS)) {
+    if (match(p, TOK_EQUALS)) {
         initializer = expression(p);
     }
     expect(p, TOK_SEMICOLON, "Expected ';' at the end of variable declaration");
 
-    return makeVarStmt(type, storageClass, identifier, initializer);
+    return makeVarStmt(p->arena, type, storageClass, identifier, initializer);
 }
 
 static Stmt *enumStmt(Parser *p) {
     expect(p, TOK_IDENTIFIER, "Expected enum name");
     Token name = previous(p);
 
-    TokensList entries = {0};
     expect(p, TOK_LEFT_BRACE, "Expected '{' in enum declaration");
 
+    p->entries.len = 0;
     do {
-        if (match(p, 1, TOK_IDENTIFIER)) {
-            appendSingle(&entries, previous(p));
+        if (match(p, TOK_IDENTIFIER)) {
+            appendSingle(&p->entries, previous(p));
         }
-    } while (match(p, 1, TOK_COMMA));
+    } while (match(p, TOK_COMMA));
 
     expect(p, TOK_RIGHT_BRACE, "Expected '}' to end enum declaration");
-    return makeEnumStmt(name, entries);
+    TokensList entries = {
+        .arr = arenaCopy(p->arena, ARENA_LIST, p->entries.arr, p->entries.len * sizeof(Token)),
+        .len = p->entries.len,
+        .cap = p->entries.len,
+    };
+    return makeEnumStmt(p->arena, name, entries);
+}
+
+/**********************************************************************************************************************
+ * Parallel Parsing
+ * Top level statements don't depend on each other, so the token list is cut after a ';' or '}' outside of any
+ * brackets and every chunk is parsed on its own thread into its own arena. Chunks are concatenated in source order
+ * and their arenas merged into the caller's.
+ * On valid input every cut is where the sequential parser would start a statement, on invalid input recovery may
+ * resynchronize elsewhere. So as soon as a chunk has an error the whole unit is parsed again sequentially, which keeps
+ * the diagnostics identical and only costs time on files that don't compile anyway.
+ *********************************************************************************************************************/
+
+// Smaller chunks aren't worth a thread
+#define PARALLEL_PARSE_MIN_CHUNK 16384
+
+typedef struct {
+    TokensList tokens; // View into the whole list
+    TokenStream stream;
+    Arena arena;
+    Diagnostics diagnostics;
+    StmtList statements;
+} ParseChunk;
+
+static void *parseChunk(void *arg) {
+    ParseChunk *chunk = arg;
+    chunk->statements = parseStream(&chunk->arena, &chunk->stream, &chunk->diagnostics);
+    return NULL;
+}
+
+// Run `work` on every chunk, one thread each. Chunks whose thread can't be started run on the calling thread.
+static void runChunks(ParseChunk *chunks, usize count, void *(*work)(void *)) {
+    pthread_t *threads = calloc(count, sizeof(pthread_t));
+    Bool *started = calloc(count, sizeof(Bool));
+    if (threads == NULL || started == NULL) exit(1);
+
+    for (usize i = 1; i < count; i++) started[i] = pthread_create(&threads[i], NULL, work, &chunks[i]) == 0;
+    work(&chunks[0]);
+    for (usize i = 1; i < count; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+        else
+            work(&chunks[i]);
+    }
+
+    free(threads);
+    free(started);
+}
+
+// Index of the first top level statement boundary at or after `from`, scanning on from `index` at bracket `depth`
+static usize nextBoundary(const TokensList *tokens, usize from, usize *index, i64 *depth) {
+    usize i = *index;
+    for (; i < tokens->len; i++) {
+        TokenType type = tokens->arr[i].type;
+        if (type == TOK_LEFT_PAREN || type == TOK_LEFT_BRACKET || type == TOK_LEFT_BRACE) (*depth)++;
+        else if (type == TOK_RIGHT_PAREN || type == TOK_RIGHT_BRACKET || type == TOK_RIGHT_BRACE) (*depth)--;
+        else if (type != TOK_SEMICOLON) continue;
+
+        if (*depth == 0 && i + 1 >= from && (type == TOK_SEMICOLON || type == TOK_RIGHT_BRACE)) {
+            *index = i + 1;
+            return i + 1;
+        }
+    }
+    *index = tokens->len;
+    return tokens->len;
 }
 
 /****************************************************************************
  * Public API
  *****************************************************************************/
 
-StmtList parse(TokensList tokens) {
-    if (tokens.len == 0) {
-        fprintf(stderr, "No tokens to parse\n");
-        return (StmtList){0};
+StmtList parseStream(Arena *arena, TokenStream *tokens, Diagnostics *diagnostics) {
+    Parser parser = {
+        .arena = arena,
+        .input = tokens,
+        .previous = {0},
+        .fileName = {0},
+        .hasErrors = FALSE,
+        .stop = FALSE,
+        .diagnostics = diagnostics,
+        .entries = {0},
+        .args = {0},
+    };
+
+    StmtList translationUnit = {0};
+    while (!isAtEnd(&parser) && !parser.stop) {
+        Stmt *stmt = declaration(&parser);
+        if (stmt != NULL) appendSingle(&translationUnit, stmt);
     }
+    ARENA_ADOPT_LIST(arena, &translationUnit);
+    free(parser.entries.arr);
+    free(parser.args.arr);
 
+    return translationUnit;
+}
+
+Stmt *parseStatement(Arena *arena, TokenStream *tokens, Diagnostics *diagnostics) {
     Parser parser = {
+        .arena = arena,
         .input = tokens,
+        .previous = {0},
         .fileName = {0},
-        .index = 0,
         .hasErrors = FALSE,
+        .stop = FALSE,
+        .diagnostics = diagnostics,
+        .entries = {0},
+        .args = {0},
     };
 
+    Stmt *stmt = declaration(&parser);
+    free(parser.entries.arr);
+    free(parser.args.arr);
+    return stmt;
+}
+
+StmtList parse(Arena *arena, const SourceFile *source, TokensList tokens, Diagnostics *diagnostics) {
+    if (tokens.len == 0) {
+        fprintf(stderr, "No tokens to parse\n");
+        return (StmtList){0};
+    }
+
+    TokenStream stream;
+    openListTokenStream(&stream, source, &tokens);
+    StmtList translationUnit = parseStream(arena, &stream, diagnostics);
+    closeTokenStream(&stream);
+    return translationUnit;
+}
+
+StmtList parseParallel(Arena *arena, const SourceFile *source, TokensList tokens, Diagnostics *diagnostics,
+                       usize threads) {
+    usize count = threads;
+    if (count > tokens.len / PARALLEL_PARSE_MIN_CHUNK) count = tokens.len / PARALLEL_PARSE_MIN_CHUNK;
+    if (count <= 1) return parse(arena, source, tokens, diagnostics);
+
+    ParseChunk *chunks = calloc(count, sizeof(ParseChunk));
+    if (chunks == NULL) exit(1);
+
+    usize start = 0;
+    usize index = 0;
+    i64 depth = 0;
+    for (usize i = 0; i < count; i++) {
+        usize end = i + 1 < count ? nextBoundary(&tokens, tokens.len * (i + 1) / count, &index, &depth) : tokens.len;
+
+        ParseChunk *chunk = &chunks[i];
+        chunk->tokens = (TokensList){.arr = tokens.arr + start, .len = end - start, .cap = end - start};
+        openListTokenStream(&chunk->stream, source, &chunk->tokens);
+        // Any error sends us back to the sequential parser, the first one is all a chunk needs to find
+        chunk->diagnostics.limit = 1;
+        start = end;
+    }
+
+    runChunks(chunks, count, parseChunk);
+
+    Bool hasErrors = FALSE;
+    usize total = 0;
+    for (usize i = 0; i < count; i++) {
+        hasErrors |= chunks[i].diagnostics.len > 0;
+        total += chunks[i].statements.len;
+    }
+
     StmtList translationUnit = {0};
-    while (!isAtEnd(&parser)) {
-        Stmt *stmt = statement(&parser);
-        appendSingle(&translationUnit, stmt);
+    if (!hasErrors) {
+        translationUnit.arr = arenaAlloc(arena, ARENA_LIST, total * sizeof(Stmt *));
+        translationUnit.cap = total;
+        for (usize i = 0; i < count; i++) {
+            StmtList *statements = &chunks[i].statements;
+            memcpy(translationUnit.arr + translationUnit.len, statements->arr, statements->len * sizeof(Stmt *));
+            translationUnit.len += statements->len;
+        }
+    }
+
+    for (usize i = 0; i < count; i++) {
+        closeTokenStream(&chunks[i].stream);
+        freeDiagnostics(&chunks[i].diagnostics);
+        if (hasErrors)
+            freeArena(&chunks[i].arena);
+        else
+            mergeArena(arena, &chunks[i].arena);
     }
+    free(chunks);
 
+    if (hasErrors) return parse(arena, source, tokens, diagnostics);
     return translationUnit;
 }
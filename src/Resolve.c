@@ -0,0 +1,224 @@
+#include "Resolve.h"
+
+#include <libk/Errors.h>
+
+#define SYMBOL_TABLE_INITIAL_SLOTS 256
+
+// Slot key of a name, enum names get the odd keys so they never collide with variables or enum constants
+static u32 symbolKey(Symbol name, Bool isEnum) {
+    ILLEGAL(name >= (1u << 31), "Too many symbols for the symbol table");
+    return (name << 1 | isEnum) + 1;
+}
+
+static usize slotIndex(u32 key, usize cap) { return (key * 0x9E3779B97F4A7C15ull) >> 32 & (cap - 1); }
+
+// Slot holding `key`, or the empty slot where it would go
+static SymbolSlot *findSlot(const SymbolTable *table, u32 key) {
+    usize slot = slotIndex(key, table->slotsCap);
+    while (table->slots[slot].key != 0 && table->slots[slot].key != key) slot = (slot + 1) & (table->slotsCap - 1);
+    return &table->slots[slot];
+}
+
+static void growSlots(SymbolTable *table) {
+    SymbolSlot *oldSlots = table->slots;
+    usize oldCap = table->slotsCap;
+
+    table->slotsCap = oldCap == 0 ? SYMBOL_TABLE_INITIAL_SLOTS : oldCap * 2;
+    table->slots = calloc(table->slotsCap, sizeof(SymbolSlot));
+    if (table->slots == NULL) exit(1);
+    for (usize i = 0; i < oldCap; i++)
+        if (oldSlots[i].key != 0) *findSlot(table, oldSlots[i].key) = oldSlots[i];
+    free(oldSlots);
+}
+
+static u32 lookupKey(const SymbolTable *table, u32 key) {
+    if (table->slotsCap == 0) return NO_DECLARATION;
+    const SymbolSlot *slot = findSlot(table, key);
+    return slot->key == key ? slot->declaration : NO_DECLARATION;
+}
+
+static Bool hasInitializer(const Declaration *declaration) {
+    return declaration->stmt != NULL && declaration->stmt->as.declaration.initializer != NULL;
+}
+
+// C allows declaring a file scope variable again, as long as at most one of the declarations defines its value.
+// `previous` is the latest declaration in the same scope, it knows whether any of the earlier ones did.
+static Bool mayRedeclare(const Declaration *previous, const Declaration *next) {
+    if (previous->kind != DECL_VARIABLE || next->kind != DECL_VARIABLE || next->scope != 0) return FALSE;
+    return !previous->isDefined || !next->isDefined;
+}
+
+/**********************************************************************************************************************
+ * Resolving
+ *********************************************************************************************************************/
+
+typedef struct {
+    SymbolTable *table;
+    Diagnostics *diagnostics;
+} Resolver;
+
+static Bool resolveStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    Resolver *resolver = ctx;
+    // Walks hand out const nodes, this pass owns the tree it rewrites
+    Expr *root = (Expr *)node.node;
+
+    const Expr *next = exprChild(root, step);
+    if (next != NULL) {
+        *child = (WalkNode){.kind = WALK_EXPR, .node = next};
+        return TRUE;
+    }
+    if (root->type != EXPR_LITERAL || root->as.primary.value.type != TOK_IDENTIFIER) return FALSE;
+
+    Token name = root->as.primary.value;
+    u32 index = lookupSymbol(resolver->table, name.as.identifier.symbol);
+    if (index == NO_DECLARATION) {
+        reportDiagnostic(resolver->diagnostics, name.offset, "Use of an undeclared identifier");
+        return FALSE;
+    }
+
+    const Declaration *declaration = &resolver->table->declarations.arr[index];
+    if (declaration->kind == DECL_ENUM_CONSTANT) {
+        Constant value = {.type = TOK_I32, .as.integer = (u64)declaration->value};
+        root->type = EXPR_CONSTANT;
+        root->as.constant = (ConstantExpr){.value = value, .offset = name.offset};
+        return FALSE;
+    }
+    root->as.primary.declaration = index;
+    return FALSE;
+}
+
+static void resolveType(Resolver *resolver, Type *type) {
+    while (type != NULL) {
+        switch (type->kind) {
+            case TYPE_SIMPLE:
+                return;
+            case TYPE_POINTER:
+                type = type->as.pointer;
+                break;
+            case TYPE_ARRAY:
+                resolveExpr(resolver->table, type->as.array.size, resolver->diagnostics);
+                type = type->as.array.inner;
+                break;
+        }
+    }
+}
+
+static void declare(Resolver *resolver, Declaration declaration, cstr redefinition) {
+    if (declareSymbol(resolver->table, declaration) == NO_DECLARATION)
+        reportDiagnostic(resolver->diagnostics, declaration.offset, redefinition);
+}
+
+static void resolveVariable(Resolver *resolver, Stmt *stmt) {
+    VarStmt *var = &stmt->as.declaration;
+    resolveType(resolver, var->type);
+    Declaration declaration = {
+        .kind = DECL_VARIABLE,
+        .name = var->identifier.as.identifier.symbol,
+        .offset = var->identifier.offset,
+        .stmt = stmt,
+    };
+    declare(resolver, declaration, "Redefinition of a name declared in the same scope");
+    resolveExpr(resolver->table, var->initializer, resolver->diagnostics);
+}
+
+// Enumerators count up from 0, each one is in scope right after it is declared
+static void resolveEnum(Resolver *resolver, Stmt *stmt) {
+    EnumStmt *enumStmt = &stmt->as.enumStmt;
+    Declaration declaration = {
+        .kind = DECL_ENUM,
+        .name = enumStmt->name.as.identifier.symbol,
+        .offset = enumStmt->name.offset,
+        .stmt = stmt,
+    };
+    declare(resolver, declaration, "Redefinition of an enum");
+
+    for (usize i = 0; i < enumStmt->entries.len; i++) {
+        Token entry = enumStmt->entries.arr[i];
+        declaration = (Declaration){
+            .kind = DECL_ENUM_CONSTANT,
+            .name = entry.as.identifier.symbol,
+            .offset = entry.offset,
+            .stmt = stmt,
+            .value = (i64)i,
+        };
+        declare(resolver, declaration, "Redefinition of a name declared in the same scope");
+    }
+}
+
+/**********************************************************************************************************************
+ * Public Symbol Table API
+ *********************************************************************************************************************/
+
+void pushScope(SymbolTable *table) { appendSingle(&table->scopes, table->bindings.len); }
+
+void popScope(SymbolTable *table) {
+    ILLEGAL(table->scopes.len == 0, "No scope to leave");
+    usize start = table->scopes.arr[--table->scopes.len];
+    while (table->bindings.len > start) {
+        const Declaration *declaration = &table->declarations.arr[table->bindings.arr[--table->bindings.len]];
+        SymbolSlot *slot = findSlot(table, symbolKey(declaration->name, declaration->kind == DECL_ENUM));
+        slot->declaration = declaration->shadowed;
+    }
+}
+
+u32 declareSymbol(SymbolTable *table, Declaration declaration) {
+    // Keep the load factor under 1/2, slots are never emptied so names that went out of scope count as well
+    if (2 * (table->slotsLen + 1) > table->slotsCap) growSlots(table);
+
+    u32 key = symbolKey(declaration.name, declaration.kind == DECL_ENUM);
+    SymbolSlot *slot = findSlot(table, key);
+    if (slot->key == 0) {
+        *slot = (SymbolSlot){.key = key, .declaration = NO_DECLARATION};
+        table->slotsLen++;
+    }
+
+    declaration.scope = (u32)table->scopes.len;
+    declaration.isDefined = hasInitializer(&declaration);
+    if (slot->declaration != NO_DECLARATION) {
+        const Declaration *previous = &table->declarations.arr[slot->declaration];
+        if (previous->scope == declaration.scope) {
+            if (!mayRedeclare(previous, &declaration)) return NO_DECLARATION;
+            declaration.isDefined = declaration.isDefined || previous->isDefined;
+        }
+    }
+    declaration.shadowed = slot->declaration;
+
+    u32 index = (u32)table->declarations.len;
+    appendSingle(&table->declarations, declaration);
+    appendSingle(&table->bindings, index);
+    slot->declaration = index;
+    return index;
+}
+
+u32 lookupSymbol(const SymbolTable *table, Symbol name) { return lookupKey(table, symbolKey(name, FALSE)); }
+
+u32 lookupEnum(const SymbolTable *table, Symbol name) { return lookupKey(table, symbolKey(name, TRUE)); }
+
+void freeSymbolTable(SymbolTable *table) {
+    free(table->declarations.arr);
+    free(table->bindings.arr);
+    free(table->scopes.arr);
+    free(table->slots);
+    *table = (SymbolTable){0};
+}
+
+void resolveExpr(SymbolTable *table, Expr *root, Diagnostics *diagnostics) {
+    if (root == NULL) return;
+    Resolver resolver = {.table = table, .diagnostics = diagnostics};
+    walk((WalkNode){.kind = WALK_EXPR, .node = root}, resolveStep, &resolver);
+}
+
+void resolveStmtList(SymbolTable *table, StmtList list, Diagnostics *diagnostics) {
+    Resolver resolver = {.table = table, .diagnostics = diagnostics};
+    for (usize i = 0; i < list.len; i++) {
+        Stmt *stmt = list.arr[i];
+        switch (stmt->type) {
+            case STMT_DECLARATION:
+                resolveVariable(&resolver, stmt);
+                break;
+            case STMT_ENUM:
+                resolveEnum(&resolver, stmt);
+                break;
+        }
+    }
+}
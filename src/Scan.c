@@ -0,0 +1,150 @@
+#include "Scan.h"
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+const u8 charClass[256] = {
+    [' '] = CHAR_BLANK, ['\t'] = CHAR_BLANK, ['\r'] = CHAR_BLANK,
+    ['0'] = CHAR_DIGIT, ['1'] = CHAR_DIGIT, ['2'] = CHAR_DIGIT, ['3'] = CHAR_DIGIT, ['4'] = CHAR_DIGIT,
+    ['5'] = CHAR_DIGIT, ['6'] = CHAR_DIGIT, ['7'] = CHAR_DIGIT, ['8'] = CHAR_DIGIT, ['9'] = CHAR_DIGIT,
+    ['a'] = CHAR_ALPHA, ['b'] = CHAR_ALPHA, ['c'] = CHAR_ALPHA, ['d'] = CHAR_ALPHA, ['e'] = CHAR_ALPHA,
+    ['f'] = CHAR_ALPHA, ['g'] = CHAR_ALPHA, ['h'] = CHAR_ALPHA, ['i'] = CHAR_ALPHA, ['j'] = CHAR_ALPHA,
+    ['k'] = CHAR_ALPHA, ['l'] = CHAR_ALPHA, ['m'] = CHAR_ALPHA, ['n'] = CHAR_ALPHA, ['o'] = CHAR_ALPHA,
+    ['p'] = CHAR_ALPHA, ['q'] = CHAR_ALPHA, ['r'] = CHAR_ALPHA, ['s'] = CHAR_ALPHA, ['t'] = CHAR_ALPHA,
+    ['u'] = CHAR_ALPHA, ['v'] = CHAR_ALPHA, ['w'] = CHAR_ALPHA, ['x'] = CHAR_ALPHA, ['y'] = CHAR_ALPHA,
+    ['z'] = CHAR_ALPHA,
+    ['A'] = CHAR_ALPHA, ['B'] = CHAR_ALPHA, ['C'] = CHAR_ALPHA, ['D'] = CHAR_ALPHA, ['E'] = CHAR_ALPHA,
+    ['F'] = CHAR_ALPHA, ['G'] = CHAR_ALPHA, ['H'] = CHAR_ALPHA, ['I'] = CHAR_ALPHA, ['J'] = CHAR_ALPHA,
+    ['K'] = CHAR_ALPHA, ['L'] = CHAR_ALPHA, ['M'] = CHAR_ALPHA, ['N'] = CHAR_ALPHA, ['O'] = CHAR_ALPHA,
+    ['P'] = CHAR_ALPHA, ['Q'] = CHAR_ALPHA, ['R'] = CHAR_ALPHA, ['S'] = CHAR_ALPHA, ['T'] = CHAR_ALPHA,
+    ['U'] = CHAR_ALPHA, ['V'] = CHAR_ALPHA, ['W'] = CHAR_ALPHA, ['X'] = CHAR_ALPHA, ['Y'] = CHAR_ALPHA,
+    ['Z'] = CHAR_ALPHA,
+    ['_'] = CHAR_ALPHA,
+};
+
+/**********************************************************************************************************************
+ * Scalar scanners
+ *********************************************************************************************************************/
+
+static inline usize scanClass(const u8 *data, usize len, u8 class) {
+    usize i = 0;
+    while (i < len && (charClass[data[i]] & class)) i++;
+    return i;
+}
+
+static usize blanksScalar(const u8 *data, usize len) { return scanClass(data, len, CHAR_BLANK); }
+static usize identifierScalar(const u8 *data, usize len) { return scanClass(data, len, CHAR_ALPHA | CHAR_DIGIT); }
+static usize digitsScalar(const u8 *data, usize len) { return scanClass(data, len, CHAR_DIGIT); }
+
+static const Scanner scalarScanner = {
+    .blanks = blanksScalar,
+    .identifier = identifierScalar,
+    .digits = digitsScalar,
+};
+
+#ifdef __x86_64__
+
+/**********************************************************************************************************************
+ * SSE2 scanners - 16 bytes at a time
+ * All classes are ASCII, bytes >= 0x80 are negative as signed chars and fail every range check.
+ *********************************************************************************************************************/
+
+// Bytes of v in [lo, hi]
+static inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), v));
+}
+
+static inline __m128i blanks16(__m128i v) {
+    __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+    __m128i tab = _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'));
+    __m128i cr = _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'));
+    return _mm_or_si128(space, _mm_or_si128(tab, cr));
+}
+
+static inline __m128i digits16(__m128i v) { return inRange16(v, '0', '9'); }
+
+static inline __m128i identifier16(__m128i v) {
+    // Setting bit 5 folds 'A'-'Z' onto 'a'-'z' and maps nothing else there
+    __m128i letters = inRange16(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return _mm_or_si128(_mm_or_si128(letters, underscore), digits16(v));
+}
+
+#define DEFINE_SSE2_SCANNER(name, classify, class)                                                                     \
+    static usize name##Sse2(const u8 *data, usize len) {                                                               \
+        usize i = 0;                                                                                                   \
+        for (; i + 16 <= len; i += 16) {                                                                               \
+            __m128i v = _mm_loadu_si128((const __m128i *)(data + i));                                                  \
+            u32 outside = ~(u32)_mm_movemask_epi8(classify(v)) & 0xFFFF;                                               \
+            if (outside != 0) return i + __builtin_ctz(outside);                                                       \
+        }                                                                                                              \
+        return i + scanClass(data + i, len - i, class);                                                                \
+    }
+
+DEFINE_SSE2_SCANNER(blanks, blanks16, CHAR_BLANK)
+DEFINE_SSE2_SCANNER(identifier, identifier16, CHAR_ALPHA | CHAR_DIGIT)
+DEFINE_SSE2_SCANNER(digits, digits16, CHAR_DIGIT)
+
+static const Scanner sse2Scanner = {
+    .blanks = blanksSse2,
+    .identifier = identifierSse2,
+    .digits = digitsSse2,
+};
+
+/**********************************************************************************************************************
+ * AVX2 scanners - 32 bytes at a time, only called after checking the CPU supports them
+ *********************************************************************************************************************/
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+AVX2 static inline __m256i blanks32(__m256i v) {
+    __m256i space = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '));
+    __m256i tab = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'));
+    __m256i cr = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'));
+    return _mm256_or_si256(space, _mm256_or_si256(tab, cr));
+}
+
+AVX2 static inline __m256i digits32(__m256i v) { return inRange32(v, '0', '9'); }
+
+AVX2 static inline __m256i identifier32(__m256i v) {
+    __m256i letters = inRange32(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+    __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return _mm256_or_si256(_mm256_or_si256(letters, underscore), digits32(v));
+}
+
+#define DEFINE_AVX2_SCANNER(name, classify)                                                                            \
+    AVX2 static usize name##Avx2(const u8 *data, usize len) {                                                          \
+        usize i = 0;                                                                                                   \
+        for (; i + 32 <= len; i += 32) {                                                                               \
+            __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));                                               \
+            u32 outside = ~(u32)_mm256_movemask_epi8(classify(v));                                                     \
+            if (outside != 0) return i + __builtin_ctz(outside);                                                       \
+        }                                                                                                              \
+        return i + name##Sse2(data + i, len - i);                                                                      \
+    }
+
+DEFINE_AVX2_SCANNER(blanks, blanks32)
+DEFINE_AVX2_SCANNER(identifier, identifier32)
+DEFINE_AVX2_SCANNER(digits, digits32)
+
+static const Scanner avx2Scanner = {
+    .blanks = blanksAvx2,
+    .identifier = identifierAvx2,
+    .digits = digitsAvx2,
+};
+
+#endif // __x86_64__
+
+const Scanner *selectScanner(void) {
+#ifdef __x86_64__
+    if (__builtin_cpu_supports("avx2")) return &avx2Scanner;
+    if (__builtin_cpu_supports("sse2")) return &sse2Scanner;
+#endif
+    return &scalarScanner;
+}
@@ -0,0 +1,189 @@
+#include "Source.h"
+
+#include <libk/List.h>
+#include <libk/StringBuilder.h>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Map a regular file read-only. Returns FALSE if the file can't be mapped, in which case the caller falls back to
+// reading it.
+static Bool mapFile(SourceFile *dest, cstr path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return FALSE;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return FALSE;
+    }
+
+    // mmap refuses zero length mappings, an empty file is just an empty source
+    if (st.st_size == 0) {
+        close(fd);
+        dest->contents = (String){0};
+        dest->isMapped = TRUE;
+        return TRUE;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps its own reference to the file
+    if (data == MAP_FAILED) return FALSE;
+
+    // The lexer makes a single forward pass over the input
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    dest->contents = (String){.data = data, .len = st.st_size};
+    dest->isMapped = TRUE;
+    return TRUE;
+}
+
+/**********************************************************************************************************************
+ * Public Source API
+ *********************************************************************************************************************/
+
+ErrCode openSourceFile(SourceFile *dest, cstr path) {
+    if (dest == NULL) return NULLPTR_ERR;
+
+    dest->path = (String){.data = (u8 *)path, .len = strlen(path)};
+    dest->lineStarts = NULL;
+    dest->capacity = 0;
+    if (!mapFile(dest, path)) {
+        StringBuilder input = {0};
+        ErrCode err = joinEntireFile(&input, path);
+        if (err != NO_ERR) return err;
+
+        dest->capacity = input.cap;
+        dest->contents = moveToString(&input);
+        dest->isMapped = FALSE;
+    }
+
+    // Tokens only record byte offsets, diagnostics and printers map them back to lines through this index
+    buildLineIndex(dest);
+    return NO_ERR;
+}
+
+void buildLineIndex(SourceFile *source) {
+    if (source->lineStarts != NULL) return;
+
+    struct {
+        LIST_FIELDS(u32);
+    } lineStarts = {0};
+    appendSingle(&lineStarts, 0);
+
+    u8 *data = source->contents.data;
+    u8 *end = data + source->contents.len;
+    for (u8 *nl = data; nl < end && (nl = memchr(nl, '\n', end - nl)) != NULL; nl++) {
+        appendSingle(&lineStarts, (u32)(nl + 1 - data));
+    }
+
+    source->lineStarts = lineStarts.arr;
+    source->lineCount = lineStarts.len;
+}
+
+SourceLocation locateOffset(const SourceFile *source, u32 offset) {
+    ILLEGAL(source->lineStarts == NULL, "Locating an offset without a line index");
+
+    // Last line starting at or before offset
+    usize lo = 0, hi = source->lineCount;
+    while (hi - lo > 1) {
+        usize mid = lo + (hi - lo) / 2;
+        if (source->lineStarts[mid] <= offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    return (SourceLocation){.line = lo + 1, .col = offset - source->lineStarts[lo] + 1};
+}
+
+SourceLocation locateOffsetFrom(const SourceFile *source, u32 offset, usize *hint) {
+    usize line = *hint;
+    if (line >= source->lineCount || source->lineStarts[line] > offset) {
+        SourceLocation location = locateOffset(source, offset);
+        *hint = location.line - 1;
+        return location;
+    }
+
+    while (line + 1 < source->lineCount && source->lineStarts[line + 1] <= offset) line++;
+    *hint = line;
+    return (SourceLocation){.line = line + 1, .col = offset - source->lineStarts[line] + 1};
+}
+
+void closeSourceFile(SourceFile *source) {
+    free(source->lineStarts);
+    source->lineStarts = NULL;
+    source->lineCount = 0;
+
+    if (source->isMapped) {
+        if (source->contents.len > 0) munmap(source->contents.data, source->contents.len);
+    } else {
+        free(source->contents.data);
+    }
+
+    source->contents = (String){0};
+    source->isMapped = FALSE;
+    source->capacity = 0;
+}
+
+ErrCode editSourceFile(SourceFile *source, u32 start, u32 end, String text) {
+    if (source == NULL) return NULLPTR_ERR;
+    ILLEGAL(start > end || end > source->contents.len, "Edit outside of the source");
+
+    usize oldLen = source->contents.len;
+    usize newLen = oldLen - (end - start) + text.len;
+    // Token offsets are 32 bit
+    if (newLen > U32_MAX) return ALLOC_ERR;
+
+    if (source->isMapped || newLen > source->capacity) {
+        usize capacity = source->capacity > 0 ? source->capacity : 64;
+        while (capacity < newLen) capacity *= 2;
+
+        u8 *data = source->isMapped ? malloc(capacity) : realloc(source->contents.data, capacity);
+        if (data == NULL) return ALLOC_ERR;
+        if (source->isMapped) {
+            if (oldLen > 0) {
+                memcpy(data, source->contents.data, oldLen);
+                munmap(source->contents.data, oldLen);
+            }
+            source->isMapped = FALSE;
+        }
+        source->contents.data = data;
+        source->capacity = capacity;
+    }
+
+    u8 *data = source->contents.data;
+    memmove(data + start + text.len, data + end, oldLen - end);
+    memcpy(data + start, text.data, text.len);
+    source->contents.len = newLen;
+
+    if (source->lineStarts == NULL) return NO_ERR;
+
+    // Line starts inside the replaced range go, the ones in `text` come in, everything after moves along
+    usize first = locateOffset(source, start).line; // Index of the first line starting after `start`
+    usize last = first;
+    while (last < source->lineCount && source->lineStarts[last] <= end) last++;
+
+    usize added = 0;
+    for (usize i = 0; i < text.len; i++) added += text.data[i] == '\n';
+
+    usize lineCount = source->lineCount - (last - first) + added;
+    // Big enough for both the old and the new index while the tail moves
+    usize size = (lineCount > source->lineCount ? lineCount : source->lineCount) * sizeof(u32);
+    u32 *lineStarts = realloc(source->lineStarts, size);
+    if (lineStarts == NULL) return ALLOC_ERR;
+    memmove(lineStarts + first + added, lineStarts + last, (source->lineCount - last) * sizeof(u32));
+
+    for (usize i = 0, line = first; i < text.len; i++) {
+        if (text.data[i] == '\n') lineStarts[line++] = start + i + 1;
+    }
+    i64 delta = (i64)text.len - (end - start);
+    for (usize line = first + added; line < lineCount; line++) lineStarts[line] += delta;
+
+    source->lineStarts = lineStarts;
+    source->lineCount = lineCount;
+    return NO_ERR;
+}
@@ -1,8 +1,8 @@
 #include "Statement.h"
 #include <stdio.h>
 
-Stmt *makeVarStmt(Type *type, StorageClass storageClass, Token identifier, Expr *initializer) {
-    Stmt *s = malloc(sizeof(Stmt));
+Stmt *makeVarStmt(Arena *arena, Type *type, StorageClass storageClass, Token identifier, Expr *initializer) {
+    Stmt *s = ARENA_NEW(arena, ARENA_STMT, Stmt);
     s->type = STMT_DECLARATION;
     s->as.declaration.type = type;
     s->as.declaration.storageClass = storageClass;
@@ -11,14 +11,44 @@ Stmt *makeVarStmt(Type *type, StorageClass storageClass, Token identifier, Expr
     return s;
 }
 
-Stmt *makeEnumStmt(Token name, TokensList entries) {
-    Stmt *s = malloc(sizeof(Stmt));
+Stmt *makeEnumStmt(Arena *arena, Token name, TokensList entries) {
+    Stmt *s = ARENA_NEW(arena, ARENA_STMT, Stmt);
     s->type = STMT_ENUM;
     s->as.enumStmt.name = name;
     s->as.enumStmt.entries = entries;
     return s;
 }
 
+void shiftStmt(Stmt *stmt, i64 delta) {
+    switch (stmt->type) {
+        case STMT_DECLARATION:
+            for (Type *type = stmt->as.declaration.type; type != NULL;) {
+                switch (type->kind) {
+                    case TYPE_SIMPLE:
+                        shiftToken(&type->as.simple, delta);
+                        type = NULL;
+                        break;
+                    case TYPE_POINTER:
+                        type = type->as.pointer;
+                        break;
+                    case TYPE_ARRAY:
+                        shiftExpr(type->as.array.size, delta);
+                        type = type->as.array.inner;
+                        break;
+                }
+            }
+            shiftToken(&stmt->as.declaration.identifier, delta);
+            shiftExpr(stmt->as.declaration.initializer, delta);
+            break;
+        case STMT_ENUM:
+            shiftToken(&stmt->as.enumStmt.name, delta);
+            for (usize i = 0; i < stmt->as.enumStmt.entries.len; i++) {
+                shiftToken(&stmt->as.enumStmt.entries.arr[i], delta);
+            }
+            break;
+    }
+}
+
 static void printIndent(int indent) {
     for (int i = 0; i < indent; i++) printf("  ");
 }
@@ -29,50 +59,62 @@ static cstr storageClassStrings[] = {
     [STORAGE_STATIC] = "static",
 };
 
-static void printTypeImpl(Type *type, usize indent) {
-    printf("{\n");
-    switch (type->kind) {
-        case TYPE_SIMPLE:
-            printIndent(indent + 1);
-            printf("\"kind\": \"simple\",\n");
-            printIndent(indent + 1);
-            printf("\"const\": %s,\n", type->isConst ? "true" : "false");
-            printIndent(indent + 1);
-            printf("\"token\": ");
-            printToken(type->as.simple);
-            printf("\n");
-            break;
-        case TYPE_POINTER:
-            printIndent(indent + 1);
-            printf("\"kind\": \"pointer\",\n");
-            printIndent(indent + 1);
-            printf("\"const\": %s,\n", type->isConst ? "true" : "false");
-            printIndent(indent + 1);
-            printf("\"inner\": ");
-            printTypeImpl(type->as.pointer, indent + 1);
-            break;
-        case TYPE_ARRAY:
-            printIndent(indent + 1);
-            printf("\"kind\": \"array\",\n");
-            printIndent(indent + 1);
-            printf("\"const\": %s,\n", type->isConst ? "true" : "false");
-            printIndent(indent + 1);
-            printf("\"inner\": ");
-            printTypeImpl(type->as.array.inner, indent + 1);
-            printIndent(indent + 1);
-            if (type->as.array.size != NULL) {
-                printf("\"size\": ");
-                printExprImpl(type->as.array.size, indent + 1);
-            } else {
-                printf("\"size\": null\n");
-            }
-            break;
+static cstr typeKindStrings[] = {
+    [TYPE_SIMPLE] = "simple",
+    [TYPE_POINTER] = "pointer",
+    [TYPE_ARRAY] = "array",
+};
+
+// Types walk like expressions, array sizes are handed over to printExprStep
+static Bool printTypeStep(void *ctx, WalkNode node, u32 step, WalkNode *child) {
+    if (node.kind == WALK_EXPR) return printExprStep(ctx, node, step, child);
+
+    const SourceFile *source = ctx;
+    const Type *type = node.node;
+    usize indent = node.data;
+
+    if (step == 0) {
+        printf("{\n");
+        printIndent(indent + 1);
+        printf("\"kind\": \"%s\",\n", typeKindStrings[type->kind]);
+        printIndent(indent + 1);
+        printf("\"const\": %s,\n", type->isConst ? "true" : "false");
+        printIndent(indent + 1);
+        switch (type->kind) {
+            case TYPE_SIMPLE:
+                printf("\"token\": ");
+                printToken(source, type->as.simple);
+                printf("\n");
+                break;
+            case TYPE_POINTER:
+                printf("\"inner\": ");
+                *child = (WalkNode){.kind = WALK_TYPE, .node = type->as.pointer, .data = indent + 1};
+                return TRUE;
+            case TYPE_ARRAY:
+                printf("\"inner\": ");
+                *child = (WalkNode){.kind = WALK_TYPE, .node = type->as.array.inner, .data = indent + 1};
+                return TRUE;
+        }
+    } else if (step == 1 && type->kind == TYPE_ARRAY) {
+        printIndent(indent + 1);
+        if (type->as.array.size != NULL) {
+            printf("\"size\": ");
+            *child = (WalkNode){.kind = WALK_EXPR, .node = type->as.array.size, .data = indent + 1};
+            return TRUE;
+        }
+        printf("\"size\": null\n");
     }
+
     printIndent(indent);
     printf("}\n");
+    return FALSE;
 }
 
-static void printStmtImpl(Stmt *root, usize indent) {
+static void printTypeImpl(const SourceFile *source, Type *type, usize indent) {
+    walk((WalkNode){.kind = WALK_TYPE, .node = type, .data = indent}, printTypeStep, (void *)source);
+}
+
+static void printStmtImpl(const SourceFile *source, Stmt *root, usize indent) {
     printf("{\n");
     switch (root->type) {
         case STMT_DECLARATION:
@@ -82,15 +124,15 @@ static void printStmtImpl(Stmt *root, usize indent) {
             printf("\"storage\": \"%s\",\n", storageClassStrings[root->as.declaration.storageClass]);
             printIndent(indent + 1);
             printf("\"type\": ");
-            printTypeImpl(root->as.declaration.type, indent + 1);
+            printTypeImpl(source, root->as.declaration.type, indent + 1);
             printIndent(indent + 1);
             printf("\"identifier\": ");
-            printToken(root->as.declaration.identifier);
+            printToken(source, root->as.declaration.identifier);
             printf(",\n");
             printIndent(indent + 1);
             if (root->as.declaration.initializer != NULL) {
                 printf("\"initializer\": ");
-                printExprImpl(root->as.declaration.initializer, indent + 1);
+                printExprImpl(source, root->as.declaration.initializer, indent + 1);
             } else {
                 printf("\"initializer\": null\n");
             }
@@ -100,13 +142,13 @@ static void printStmtImpl(Stmt *root, usize indent) {
             printf("\"stmt\": \"enum\",\n");
             printIndent(indent + 1);
             printf("\"name\": ");
-            printToken(root->as.enumStmt.name);
+            printToken(source, root->as.enumStmt.name);
             printf(",\n");
             printIndent(indent + 1);
             printf("\"entries\": [\n");
             for (usize i = 0; i < root->as.enumStmt.entries.len; i++) {
                 printIndent(indent + 2);
-                printToken(root->as.enumStmt.entries.arr[i]);
+                printToken(source, root->as.enumStmt.entries.arr[i]);
                 if (i + 1 < root->as.enumStmt.entries.len) printf(",");
                 printf("\n");
             }
@@ -118,12 +160,18 @@ static void printStmtImpl(Stmt *root, usize indent) {
     printf("}");
 }
 
-void printStmtList(StmtList list) {
+void printStmtList(const SourceFile *source, StmtList list) {
+    // Nothing may be left after error recovery
+    if (list.len == 0) {
+        printf("[]\n");
+        return;
+    }
+
     printf("[\n");
     for (usize i = 0; i < list.len-1; i++) {
-        printStmtImpl(list.arr[i], 1);
+        printStmtImpl(source, list.arr[i], 1);
         printf(",\n");
     }
-    printStmtImpl(list.arr[list.len-1], 1);
+    printStmtImpl(source, list.arr[list.len-1], 1);
     printf("\n]\n");
 }
@@ -1,159 +1,170 @@
 #include "Token.h"
 #include <libk/Errors.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define X(type) [type] = #type,
 cstr tokenTypesStrings[] = {TOKEN_LIST};
 #undef X
 
+/**
+ * Keywords are recognized with a perfect hash over their first, second and last characters, so deciding between a
+ * keyword and an identifier takes a single table lookup and a single compare.
+ * The table is built at compile time from KEYWORD_LIST, two keywords landing in the same slot is reported as an
+ * overridden initializer. When adding a keyword, pick new multipliers for KEYWORD_HASH if that happens.
+ */
+#define KEYWORD_HASH(first, second, last) ((((u32)(first)) * 14 + ((u32)(second)) + ((u32)(last)) * 7) & 63)
+#define KEYWORD_TABLE_SIZE 64
+#define KEYWORD_MIN_LEN 2
+#define KEYWORD_MAX_LEN 8
+
+#define KEYWORD_LIST                                                                                                   \
+    KEYWORD('a', 'u', 'o', "auto", TOK_AUTO)                                                                           \
+    KEYWORD('b', 'o', 'l', "bool", TOK_BOOL)                                                                           \
+    KEYWORD('b', 'r', 'k', "break", TOK_BREAK)                                                                         \
+    KEYWORD('c', 'a', 'e', "case", TOK_CASE)                                                                           \
+    KEYWORD('c', 'o', 't', "const", TOK_CONST)                                                                         \
+    KEYWORD('c', 'o', 'e', "continue", TOK_CONTINUE)                                                                   \
+    KEYWORD('d', 'e', 't', "default", TOK_DEFAULT)                                                                     \
+    KEYWORD('d', 'o', 'o', "do", TOK_DO)                                                                               \
+    KEYWORD('e', 'l', 'e', "else", TOK_ELSE)                                                                           \
+    KEYWORD('e', 'n', 'm', "enum", TOK_ENUM)                                                                           \
+    KEYWORD('e', 'x', 'n', "extern", TOK_EXTERN)                                                                       \
+    KEYWORD('f', '3', '2', "f32", TOK_F32)                                                                             \
+    KEYWORD('f', '6', '4', "f64", TOK_F64)                                                                             \
+    KEYWORD('f', 'o', 'r', "for", TOK_FOR)                                                                             \
+    KEYWORD('i', '1', '6', "i16", TOK_I16)                                                                             \
+    KEYWORD('i', '3', '2', "i32", TOK_I32)                                                                             \
+    KEYWORD('i', '6', '4', "i64", TOK_I64)                                                                             \
+    KEYWORD('i', '8', '8', "i8", TOK_I8)                                                                               \
+    KEYWORD('i', 'f', 'f', "if", TOK_IF)                                                                               \
+    KEYWORD('r', 'e', 'n', "return", TOK_RETURN)                                                                       \
+    KEYWORD('s', 't', 'c', "static", TOK_STATIC)                                                                       \
+    KEYWORD('s', 't', 't', "struct", TOK_STRUCT)                                                                       \
+    KEYWORD('s', 'w', 'h', "switch", TOK_SWITCH)                                                                       \
+    KEYWORD('t', 'y', 'f', "typedef", TOK_TYPEDEF)                                                                     \
+    KEYWORD('u', '1', '6', "u16", TOK_U16)                                                                             \
+    KEYWORD('u', '3', '2', "u32", TOK_U32)                                                                             \
+    KEYWORD('u', '6', '4', "u64", TOK_U64)                                                                             \
+    KEYWORD('u', '8', '8', "u8", TOK_U8)                                                                               \
+    KEYWORD('u', 'n', 'n', "union", TOK_UNION)                                                                         \
+    KEYWORD('v', 'o', 'd', "void", TOK_VOID)                                                                           \
+    KEYWORD('w', 'h', 'e', "while", TOK_WHILE)
+
+typedef struct {
+    cstr text;
+    usize len;
+    TokenType type;
+} Keyword;
+
+#define KEYWORD(first, second, last, text, type) [KEYWORD_HASH(first, second, last)] = {text, sizeof(text) - 1, type},
+static const Keyword keywordTable[KEYWORD_TABLE_SIZE] = {KEYWORD_LIST};
+#undef KEYWORD
+
 TokenType findKeywordOrIdent(String keyword) {
     ILLEGAL(keyword.len == 0, "Empty String");
+    if (keyword.len < KEYWORD_MIN_LEN || keyword.len > KEYWORD_MAX_LEN) return TOK_IDENTIFIER;
 
-    switch (keyword.data[0]) {
-        case 'a':
-            if (compareCString(&keyword, "auto")) return TOK_AUTO;
-            break;
-        case 'b':
-            if (compareCString(&keyword, "bool")) return TOK_BOOL;
-            if (compareCString(&keyword, "break")) return TOK_BREAK;
-            break;
-        case 'c':
-            if (compareCString(&keyword, "case")) return TOK_CASE;
-            if (compareCString(&keyword, "const")) return TOK_CONST;
-            if (compareCString(&keyword, "continue")) return TOK_CONTINUE;
-            break;
-        case 'd':
-            if (compareCString(&keyword, "default")) return TOK_DEFAULT;
-            if (compareCString(&keyword, "do")) return TOK_DO;
-            break;
-        case 'e':
-            if (compareCString(&keyword, "else")) return TOK_ELSE;
-            if (compareCString(&keyword, "enum")) return TOK_ENUM;
-            if (compareCString(&keyword, "extern")) return TOK_EXTERN;
-            break;
-        case 'f':
-            if (compareCString(&keyword, "f32")) return TOK_F32;
-            if (compareCString(&keyword, "f64")) return TOK_F64;
-            if (compareCString(&keyword, "for")) return TOK_FOR;
-            break;
-        case 'i':
-            if (compareCString(&keyword, "i16")) return TOK_I16;
-            if (compareCString(&keyword, "i32")) return TOK_I32;
-            if (compareCString(&keyword, "i64")) return TOK_I64;
-            if (compareCString(&keyword, "i8")) return TOK_I8;
-            if (compareCString(&keyword, "if")) return TOK_IF;
-            break;
-        case 'r':
-            if (compareCString(&keyword, "return")) return TOK_RETURN;
-            break;
-        case 's':
-            if (compareCString(&keyword, "static")) return TOK_STATIC;
-            if (compareCString(&keyword, "struct")) return TOK_STRUCT;
-            if (compareCString(&keyword, "switch")) return TOK_SWITCH;
-            break;
-        case 't':
-            if (compareCString(&keyword, "typedef")) return TOK_TYPEDEF;
-            break;
-        case 'u':
-            if (compareCString(&keyword, "u16")) return TOK_U16;
-            if (compareCString(&keyword, "u32")) return TOK_U32;
-            if (compareCString(&keyword, "u64")) return TOK_U64;
-            if (compareCString(&keyword, "u8")) return TOK_U8;
-            if (compareCString(&keyword, "union")) return TOK_UNION;
-            break;
-        case 'v':
-            if (compareCString(&keyword, "void")) return TOK_VOID;
-            break;
-        case 'w':
-            if (compareCString(&keyword, "while")) return TOK_WHILE;
+    u32 slot = KEYWORD_HASH(keyword.data[0], keyword.data[1], keyword.data[keyword.len - 1]);
+    const Keyword *candidate = &keywordTable[slot];
+    if (candidate->len == keyword.len && memcmp(candidate->text, keyword.data, keyword.len) == 0) {
+        return candidate->type;
     }
 
     return TOK_IDENTIFIER;
 }
 
-Token makeSimple(TokenType type, usize line, usize col) {
+Token makeSimple(TokenType type, u32 offset) {
     return (Token){
         .type = type,
+        .offset = offset,
         .as.unknown = 0,
-        .line = line,
-        .col = col,
     };
 }
 
-Token makeUnknown(u8 c, usize line, usize col) {
+Token makeUnknown(u8 c, u32 offset) {
     return (Token){
         .type = TOK_UNKNOWN,
+        .offset = offset,
         .as.unknown = c,
-        .line = line,
-        .col = col,
     };
 }
 
-Token makeIdentifierToken(String ident, usize line, usize col) {
+Token makeIdentifierToken(Span ident, Symbol symbol) {
     return (Token){
         .type = TOK_IDENTIFIER,
-        .as.identifier = ident,
-        .line = line,
-        .col = col,
+        .offset = ident.offset,
+        .as.identifier.span = ident,
+        .as.identifier.symbol = symbol,
     };
 }
 
-Token makeStringLiteralToken(String strLit, usize line, usize col) {
+Token makeStringLiteralToken(Symbol strLit, u32 offset) {
     return (Token){
         .type = TOK_STRING_LITERAL,
+        .offset = offset,
         .as.stringLiteral = strLit,
-        .line = line,
-        .col = col,
     };
 }
 
-Token makeIntegerLiteralToken(u64 value, usize line, usize col) {
+Token makeIntegerLiteralToken(u64 value, u32 offset) {
     return (Token){
         .type = TOK_INTEGER_LITERAL,
+        .offset = offset,
         .as.integerLiteral = value,
-        .line = line,
-        .col = col,
     };
 }
 
-Token makeFloatLiteralToken(f64 value, usize line, usize col) {
+Token makeFloatLiteralToken(f64 value, u32 offset) {
     return (Token){
         .type = TOK_FLOAT_LITERAL,
+        .offset = offset,
         .as.floatLiteral = value,
-        .line = line,
-        .col = col,
     };
 }
 
-Token makeCharLiteralToken(u8 value, usize line, usize col) {
+Token makeCharLiteralToken(u8 value, u32 offset) {
     return (Token){
         .type = TOK_CHAR_LITERAL,
+        .offset = offset,
         .as.charLiteral = value,
-        .line = line,
-        .col = col,
     };
 }
 
-Token makeErrorToken(String errorMsg, usize line, usize col) {
+Token makeErrorToken(cstr errorMsg, u32 offset) {
     return (Token){
         .type = TOK_ERROR,
+        .offset = offset,
         .as.error = errorMsg,
-        .line = line,
-        .col = col,
     };
 }
 
+void shiftToken(Token *token, i64 delta) {
+    token->offset += delta;
+    if (token->type == TOK_IDENTIFIER) token->as.identifier.span.offset += delta;
+}
+
+String spanText(const SourceFile *source, Span span) {
+    return (String){.data = source->contents.data + span.offset, .len = span.len};
+}
+
 static Bool isPrintableChar(u8 c) { return ' ' <= c && c <= '~'; }
 
-void printToken(Token token) {
-    printf("{ [%zu:%zu] \"type\": \"%s\", ", token.line, token.col, tokenTypesStrings[token.type]);
+void printToken(const SourceFile *source, Token token) {
+    SourceLocation location = locateOffset(source, token.offset);
+    printf("{ [%zu:%zu] \"type\": \"%s\", ", location.line, location.col, tokenTypesStrings[token.type]);
     switch (token.type) {
-        case TOK_IDENTIFIER:
-            printf(", \"name\": \"%.*s\"", (int)token.as.identifier.len, token.as.identifier.data);
+        case TOK_IDENTIFIER: {
+            String name = spanText(source, token.as.identifier.span);
+            printf(", \"name\": \"%.*s\"", (int)name.len, name.data);
             break;
-        case TOK_STRING_LITERAL:
-            printf(", \"value\": \"%.*s\"", (int)token.as.stringLiteral.len, token.as.stringLiteral.data);
+        }
+        case TOK_STRING_LITERAL: {
+            String value = symbolText(token.as.stringLiteral);
+            printf(", \"value\": \"%.*s\"", (int)value.len, value.data);
             break;
+        }
         case TOK_CHAR_LITERAL:
             if (isPrintableChar(token.as.charLiteral))
                 printf(", \"value\": \"%c\"", token.as.charLiteral);
@@ -173,10 +184,70 @@ void printToken(Token token) {
                 printf(", \"value\": \"0x%02x\"", token.as.unknown);
             break;
         case TOK_ERROR:
-            printf(", \"error\": \"%.*s\"", (int)token.as.error.len, token.as.error.data);
+            printf(", \"error\": \"%s\"", token.as.error);
             break;
         default:
             break;
     }
     printf(" }");
 }
+
+/**********************************************************************************************************************
+ * Compact Tokens
+ *********************************************************************************************************************/
+
+void appendCompactToken(CompactTokensList *dest, Token token) {
+    if (dest->len == dest->cap) {
+        dest->cap = dest->cap == 0 ? 1024 : dest->cap * 2;
+        dest->types = realloc(dest->types, dest->cap * sizeof(u8));
+        dest->offsets = realloc(dest->offsets, dest->cap * sizeof(u32));
+        if (dest->types == NULL || dest->offsets == NULL) exit(1);
+    }
+    dest->types[dest->len] = (u8)token.type;
+    dest->offsets[dest->len] = token.offset;
+    dest->len++;
+
+    TokenPayload payload = {0};
+    switch (token.type) {
+        case TOK_IDENTIFIER:      payload.symbol = token.as.identifier.symbol; break;
+        case TOK_STRING_LITERAL:  payload.symbol = token.as.stringLiteral; break;
+        case TOK_CHAR_LITERAL:    payload.byte = token.as.charLiteral; break;
+        case TOK_INTEGER_LITERAL: payload.integer = token.as.integerLiteral; break;
+        case TOK_FLOAT_LITERAL:   payload.real = token.as.floatLiteral; break;
+        case TOK_UNKNOWN:         payload.byte = token.as.unknown; break;
+        case TOK_ERROR:           payload.error = token.as.error; break;
+        default:                  return;
+    }
+    appendSingle(&dest->payloads, payload);
+}
+
+Token compactToken(const CompactTokensList *tokens, usize index, usize payloadIndex) {
+    TokenType type = tokens->types[index];
+    u32 offset = tokens->offsets[index];
+
+    Token token = makeSimple(type, offset);
+    if (!tokenHasPayload(type)) return token;
+
+    TokenPayload payload = tokens->payloads.arr[payloadIndex];
+    switch (type) {
+        case TOK_IDENTIFIER:
+            token.as.identifier.symbol = payload.symbol;
+            token.as.identifier.span = (Span){.offset = offset, .len = (u32)symbolText(payload.symbol).len};
+            break;
+        case TOK_STRING_LITERAL:  token.as.stringLiteral = payload.symbol; break;
+        case TOK_CHAR_LITERAL:    token.as.charLiteral = payload.byte; break;
+        case TOK_INTEGER_LITERAL: token.as.integerLiteral = payload.integer; break;
+        case TOK_FLOAT_LITERAL:   token.as.floatLiteral = payload.real; break;
+        case TOK_UNKNOWN:         token.as.unknown = payload.byte; break;
+        case TOK_ERROR:           token.as.error = payload.error; break;
+        default:                  break;
+    }
+    return token;
+}
+
+void freeCompactTokensList(CompactTokensList *tokens) {
+    free(tokens->types);
+    free(tokens->offsets);
+    free(tokens->payloads.arr);
+    *tokens = (CompactTokensList){0};
+}
@@ -1,23 +1,23 @@
 #include "Type.h"
 
-Type *makePrimitiveType(Token simpleKind, Bool isConst) {
-    Type *t = malloc(sizeof(Type));
+Type *makePrimitiveType(Arena *arena, Token simpleKind, Bool isConst) {
+    Type *t = ARENA_NEW(arena, ARENA_TYPE, Type);
     t->isConst = isConst;
     t->kind = TYPE_SIMPLE;
     t->as.simple = simpleKind;
     return t;
 }
 
-Type *makePointerType(Type *pointerType, Bool isConst) {
-    Type *t = malloc(sizeof(Type));
+Type *makePointerType(Arena *arena, Type *pointerType, Bool isConst) {
+    Type *t = ARENA_NEW(arena, ARENA_TYPE, Type);
     t->isConst = isConst;
     t->kind = TYPE_POINTER;
     t->as.pointer = pointerType;
     return t;
 }
 
-Type *makeArrayType(Type *innerType, Expr *sizeExpr, Bool isConst) {
-    Type *t = malloc(sizeof(Type));
+Type *makeArrayType(Arena *arena, Type *innerType, Expr *sizeExpr, Bool isConst) {
+    Type *t = ARENA_NEW(arena, ARENA_TYPE, Type);
     t->isConst = isConst;
     t->kind = TYPE_ARRAY;
     t->as.array.inner = innerType;
@@ -0,0 +1,21 @@
+#include "Walk.h"
+
+#include <string.h>
+
+/**********************************************************************************************************************
+ * Public Walk API
+ *********************************************************************************************************************/
+
+void *walkGrowStack(void *arr, void *inlineArr, usize *cap, usize itemSize) {
+    usize oldCap = *cap;
+    *cap *= 2;
+    void *grown;
+    if (arr == inlineArr) {
+        grown = malloc(*cap * itemSize);
+        if (grown != NULL) memcpy(grown, inlineArr, oldCap * itemSize);
+    } else {
+        grown = realloc(arr, *cap * itemSize);
+    }
+    if (grown == NULL) exit(1);
+    return grown;
+}
@@ -1,23 +1,104 @@
+#include "Arena.h"
+#include "Fold.h"
 #include "Lexer.h"
+#include "Lower.h"
 #include "Parser.h"
+#include "Resolve.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int usage(cstr program) {
+    fprintf(stderr,
+            "Usage: %s [-j[threads]] [--arena-stats] [--resolve] [--fold] [--lower] "
+            "[-ferror-limit=n] <file>\n",
+            program);
+    return 1;
+}
 
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <file>\n", argv[0]);
-        return 1;
+    cstr path = NULL;
+    usize threads = 0;
+    Bool arenaStats = FALSE;
+    Bool resolve = FALSE;
+    Bool fold = FALSE;
+    Bool lower = FALSE;
+    // Same default as clang, 0 reports everything
+    usize errorLimit = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--arena-stats") == 0) {
+            arenaStats = TRUE;
+        } else if (strcmp(argv[i], "--resolve") == 0) {
+            resolve = TRUE;
+        } else if (strcmp(argv[i], "--fold") == 0) {
+            fold = TRUE;
+        } else if (strcmp(argv[i], "--lower") == 0) {
+            lower = TRUE;
+        } else if (strncmp(argv[i], "-ferror-limit=", 14) == 0) {
+            cstr value = argv[i] + 14;
+            char *end;
+            long n = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || n < 0) return usage(argv[0]);
+            errorLimit = n;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            long n = argv[i][2] != '\0' ? atol(argv[i] + 2) : sysconf(_SC_NPROCESSORS_ONLN);
+            threads = n > 0 ? n : 1;
+        } else if (path == NULL) {
+            path = argv[i];
+        } else {
+            return usage(argv[0]);
+        }
     }
+    if (path == NULL) return usage(argv[0]);
 
-    TokensList tokens = {0};
-    if (!scanFile(&tokens, argv[1])) {
-        fprintf(stderr, "Failed to scan file: %s\n", argv[1]);
+    SourceFile source = {0};
+    if (openSourceFile(&source, path) != NO_ERR) {
+        fprintf(stderr, "Failed to scan file: %s\n", path);
         return 1;
     }
 
-    StmtList translation_unit = parse(tokens);
-    printStmtList(translation_unit);
+    Arena arena = {0};
+    Diagnostics diagnostics = {.limit = errorLimit};
+    SymbolTable symbols = {0};
+    StmtList translation_unit;
+    if (threads > 0) {
+        // Lex the whole file up front across threads, then parse the token list across threads as well
+        TokensList tokens = {0};
+        if (!scanSourceParallel(&tokens, &source, threads)) {
+            fprintf(stderr, "Failed to scan file: %s\n", path);
+            return 1;
+        }
+        translation_unit = parseParallel(&arena, &source, tokens, &diagnostics, threads);
+        if (resolve) resolveStmtList(&symbols, translation_unit, &diagnostics);
+        if (fold) foldStmtList(translation_unit, &diagnostics);
+        if (lower) lowerStmtList(&arena, translation_unit);
+        printStmtList(&source, translation_unit);
+        freeTokensList(&tokens);
+    } else {
+        // The parser pulls tokens from the lexer as it goes, the file is never tokenized up front
+        TokenStream stream;
+        if (!openTokenStream(&stream, &source)) {
+            fprintf(stderr, "Failed to scan file: %s\n", path);
+            return 1;
+        }
+        translation_unit = parseStream(&arena, &stream, &diagnostics);
+        if (resolve) resolveStmtList(&symbols, translation_unit, &diagnostics);
+        if (fold) foldStmtList(translation_unit, &diagnostics);
+        if (lower) lowerStmtList(&arena, translation_unit);
+        printStmtList(&source, translation_unit);
+        closeTokenStream(&stream);
+    }
+
+    printDiagnostics(stderr, &source, &diagnostics);
+    int status = diagnostics.len > 0 ? 1 : 0;
 
-    freeTokensList(&tokens);
+    if (arenaStats) printArenaStats(stderr, &arena);
+    freeSymbolTable(&symbols);
+    freeDiagnostics(&diagnostics);
+    freeArena(&arena);
+    closeSourceFile(&source);
+    freeInterner();
 
-    return 0;
+    return status;
 }
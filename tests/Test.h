@@ -0,0 +1,121 @@
+#ifndef TESTS_TEST_H_
+#define TESTS_TEST_H_
+
+#include "Expression.h"
+#include "Parser.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * Helpers shared by the test drivers in this directory, see `make test`.
+ * Randomized tests draw from a fixed seed, so a failure reproduces on every run. Failures are reported on stderr and
+ * counted in testFailures, a driver exits with 1 if there were any.
+ */
+
+static usize testFailures = 0;
+
+static inline void testCheck(Bool ok, cstr what, u64 iteration) {
+    if (ok) return;
+    fprintf(stderr, "%s failed (iteration %llu)\n", what, (unsigned long long)iteration);
+    testFailures++;
+}
+
+// xorshift64, `state` must not be 0
+static inline u64 testRandom(u64 *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// Lex and parse `text` into `arena`. `text` must outlive the tree, free source->lineStarts once done with it.
+static inline StmtList testParse(Arena *arena, SourceFile *source, cstr text, Diagnostics *diagnostics) {
+    *source = (SourceFile){.contents = {.data = (u8 *)text, .len = strlen(text)}};
+    buildLineIndex(source);
+    TokensList tokens = {0};
+    scanSource(&tokens, source);
+    StmtList list = parse(arena, source, tokens, diagnostics);
+    freeTokensList(&tokens);
+    return list;
+}
+
+/**********************************************************************************************************************
+ * Random expressions
+ * Trees of everything evalExpr and the bytecode evaluate: unary, binary and logical operators, ?:, assignments,
+ * compound assignments and increments. Divisors are always (x & 15) + 1, so nothing traps. Shift counts are anything,
+ * counts outside 0..31 check that every evaluator masks them the same way.
+ *********************************************************************************************************************/
+
+typedef struct {
+    Arena *arena;
+    u64 *seed;
+    const Symbol *names; // Identifiers leaves may read, none if `nameCount` is 0
+    usize nameCount;
+} RandomExpr;
+
+static const TokenType randomBinaryOps[] = {
+    TOK_PLUS, TOK_MINUS, TOK_STAR, TOK_SLASH, TOK_PERCENT, TOK_AMPERSAND, TOK_CARET, TOK_PIPE, TOK_LESS_LESS,
+    TOK_GREATER_GREATER, TOK_PIPE_PIPE, TOK_AMPERSAND_AMPERSAND, TOK_EQUALS_EQUALS, TOK_BANG_EQUALS, TOK_LESS,
+    TOK_LESS_EQUALS, TOK_GREATER, TOK_GREATER_EQUALS,
+};
+
+static const TokenType randomAssignOps[] = {
+#define X(assignOp, op) assignOp,
+    COMPOUND_ASSIGNMENT_LIST
+#undef X
+};
+
+static const TokenType randomUnaryOps[] = {TOK_PLUS, TOK_MINUS, TOK_TILDE, TOK_BANG};
+
+#define RANDOM_PICK(r, array) ((array)[testRandom((r)->seed) % (sizeof(array) / sizeof((array)[0]))])
+
+static inline Expr *randomLeaf(RandomExpr *r) {
+    u64 pick = testRandom(r->seed);
+    if (r->nameCount > 0 && pick % 2 == 0) {
+        Token name = {.type = TOK_IDENTIFIER, .as.identifier.symbol = r->names[pick / 2 % r->nameCount]};
+        return makePrimaryExpr(r->arena, name);
+    }
+    // Mostly small values, some anywhere in int range so the arithmetic overflows
+    u64 value = pick % 4 == 1 ? testRandom(r->seed) % ((u64)1 << 31) : testRandom(r->seed) % 40;
+    Token literal = {.type = TOK_INTEGER_LITERAL, .as.integerLiteral = value};
+    return makePrimaryExpr(r->arena, literal);
+}
+
+// (divisor & 15) + 1
+static inline Expr *randomDivisor(RandomExpr *r, Expr *divisor) {
+    Token fifteen = {.type = TOK_INTEGER_LITERAL, .as.integerLiteral = 15};
+    Token one = {.type = TOK_INTEGER_LITERAL, .as.integerLiteral = 1};
+    Expr *masked = makeBinaryExpr(r->arena, TOK_AMPERSAND, divisor, makePrimaryExpr(r->arena, fifteen));
+    return makeBinaryExpr(r->arena, TOK_PLUS, makeGroupingExpr(r->arena, masked), makePrimaryExpr(r->arena, one));
+}
+
+static inline Expr *randomExpr(RandomExpr *r, usize depth) {
+    if (depth == 0) return randomLeaf(r);
+    u64 pick = testRandom(r->seed) % 20;
+    if (pick < 2) return randomLeaf(r);
+    if (pick < 4) return makeUnaryExpr(r->arena, RANDOM_PICK(r, randomUnaryOps), randomExpr(r, depth - 1));
+    if (pick < 5) return makeGroupingExpr(r->arena, randomExpr(r, depth - 1));
+    if (pick < 7) {
+        Expr *condition = randomExpr(r, depth - 1);
+        return makeConditionalExpr(r->arena, condition, randomExpr(r, depth - 1), randomExpr(r, depth - 1));
+    }
+    if (pick < 8) {
+        Token op = {.type = testRandom(r->seed) % 2 ? TOK_PLUS_PLUS : TOK_MINUS_MINUS};
+        return makeIncrementExpr(r->arena, op, testRandom(r->seed) % 2, randomLeaf(r));
+    }
+    if (pick < 9) return makeBinaryExpr(r->arena, TOK_EQUALS, randomLeaf(r), randomExpr(r, depth - 1));
+    if (pick < 11) {
+        TokenType op = RANDOM_PICK(r, randomAssignOps);
+        Expr *value = randomExpr(r, depth - 1);
+        if (op == TOK_SLASH_EQUALS || op == TOK_PERCENT_EQUALS) value = randomDivisor(r, value);
+        return makeCompoundAssignExpr(r->arena, op, randomLeaf(r), value);
+    }
+    TokenType op = RANDOM_PICK(r, randomBinaryOps);
+    Expr *lhs = randomExpr(r, depth - 1);
+    Expr *rhs = randomExpr(r, depth - 1);
+    if (op == TOK_SLASH || op == TOK_PERCENT) rhs = randomDivisor(r, rhs);
+    return makeBinaryExpr(r->arena, op, lhs, rhs);
+}
+
+#endif // TESTS_TEST_H_
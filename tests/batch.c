@@ -0,0 +1,102 @@
+#include "Batch.h"
+#include "Interner.h"
+#include "Test.h"
+
+/**
+ * runBytecodeBatch and evalExprBatch against runBytecode on every row, see Batch.h.
+ * The columns are chosen to reach every path of the batch evaluator: `c` is 0 or 1 at random, so a ?: on it goes
+ * different ways within a block and falls back to row by row evaluation, `d` flips once per block of 128 rows, so whole
+ * blocks take one branch, and `b` holds shift counts between -40 and 40. Row counts are mostly not a multiple of the
+ * block size, leaving rows after the last full block.
+ */
+
+#define BATCH_TEST_EXPRESSIONS 2000
+#define BATCH_TEST_MAX_DEPTH 5
+#define BATCH_TEST_MAX_ROWS 1000
+#define BATCH_TEST_COLUMNS 4
+
+static const usize rowCounts[] = {0, 1, 7, 127, 128, 129, 255, 256, 300, BATCH_TEST_MAX_ROWS};
+
+static int columnValues[BATCH_TEST_COLUMNS][BATCH_TEST_MAX_ROWS];
+static Symbol names[BATCH_TEST_COLUMNS];
+
+static void checkBatch(Expr *root, usize rows, u64 iteration) {
+    Bytecode code;
+    if (!compileExpr(&code, root)) {
+        testCheck(FALSE, "compiling", iteration);
+        return;
+    }
+
+    // Every row through runBytecode
+    static int expected[BATCH_TEST_MAX_ROWS], out[BATCH_TEST_MAX_ROWS];
+    const int *columns[BATCH_TEST_COLUMNS];
+    for (usize v = 0; v < code.variables.len; v++) {
+        for (usize c = 0; c < BATCH_TEST_COLUMNS; c++)
+            if (names[c] == code.variables.arr[v]) columns[v] = columnValues[c];
+    }
+    for (usize row = 0; row < rows; row++) {
+        int env[BATCH_TEST_COLUMNS];
+        for (usize v = 0; v < code.variables.len; v++) env[v] = columns[v][row];
+        expected[row] = runBytecode(&code, env);
+    }
+
+    runBytecodeBatch(&code, columns, rows, out);
+    Bool same = TRUE;
+    for (usize row = 0; row < rows; row++) same &= out[row] == expected[row];
+    testCheck(same, "runBytecodeBatch against runBytecode", iteration);
+
+    // Columns are looked up by name, in any order
+    BatchColumn bound[BATCH_TEST_COLUMNS];
+    for (usize c = 0; c < BATCH_TEST_COLUMNS; c++) {
+        usize from = BATCH_TEST_COLUMNS - 1 - c;
+        bound[c] = (BatchColumn){.name = names[from], .values = columnValues[from]};
+    }
+    same = evalExprBatch(root, bound, BATCH_TEST_COLUMNS, rows, out);
+    for (usize row = 0; row < rows && same; row++) same = out[row] == expected[row];
+    testCheck(same, "evalExprBatch against runBytecode", iteration);
+
+    if (code.variables.len > 0) testCheck(!evalExprBatch(root, NULL, 0, rows, out), "missing column", iteration);
+    freeBytecode(&code);
+}
+
+static Expr *identifier(Arena *arena, usize column) {
+    Token name = {.type = TOK_IDENTIFIER, .as.identifier.symbol = names[column]};
+    return makePrimaryExpr(arena, name);
+}
+
+int main(void) {
+    static u8 letters[] = "abcd";
+    for (usize c = 0; c < BATCH_TEST_COLUMNS; c++) names[c] = intern((String){.data = letters + c, .len = 1});
+
+    u64 seed = 24;
+    for (usize row = 0; row < BATCH_TEST_MAX_ROWS; row++) {
+        columnValues[0][row] = (int)(u32)testRandom(&seed);
+        columnValues[1][row] = (int)(testRandom(&seed) % 81) - 40;
+        columnValues[2][row] = (int)(testRandom(&seed) % 2);
+        columnValues[3][row] = (int)(row / 128 % 2);
+    }
+
+    // The paths the columns are there for, on their own
+    Arena arena = {0};
+    Expr *a = identifier(&arena, 0), *b = identifier(&arena, 1), *c = identifier(&arena, 2), *d = identifier(&arena, 3);
+    Expr *fixed[] = {
+        makeBinaryExpr(&arena, TOK_LESS_LESS, a, b),
+        makeBinaryExpr(&arena, TOK_GREATER_GREATER, a, b),
+        makeConditionalExpr(&arena, c, a, b),
+        makeConditionalExpr(&arena, d, makeBinaryExpr(&arena, TOK_PLUS, a, b), makeUnaryExpr(&arena, TOK_MINUS, a)),
+    };
+    for (usize i = 0; i < sizeof(fixed) / sizeof(fixed[0]); i++) {
+        for (usize r = 0; r < sizeof(rowCounts) / sizeof(rowCounts[0]); r++) checkBatch(fixed[i], rowCounts[r], i);
+    }
+    freeArena(&arena);
+
+    for (u64 i = 0; i < BATCH_TEST_EXPRESSIONS; i++) {
+        RandomExpr random = {.arena = &arena, .seed = &seed, .names = names, .nameCount = BATCH_TEST_COLUMNS};
+        Expr *root = randomExpr(&random, 1 + i % BATCH_TEST_MAX_DEPTH);
+        checkBatch(root, rowCounts[i % (sizeof(rowCounts) / sizeof(rowCounts[0]))], i);
+        freeArena(&arena);
+    }
+
+    freeInterner();
+    return testFailures == 0 ? 0 : 1;
+}
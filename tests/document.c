@@ -0,0 +1,126 @@
+#include "Document.h"
+#include "Interner.h"
+#include "Test.h"
+
+#include <unistd.h>
+
+/**
+ * Incremental reparsing against a full parse, see Document.h. A document opened from a generated file takes random
+ * edits, after every one of them its tokens, statements and diagnostics must be what scanSource and parse make of the
+ * whole text. Edits splice in fragments of statements as well as whole ones, so statements merge, split and break, and
+ * every few edits land at the end of the text, in the last statement. Now and then a NUL byte goes in.
+ */
+
+#define DOCUMENT_TEST_STATEMENTS 40
+#define DOCUMENT_TEST_EDITS 3000
+#define DOCUMENT_TEST_MAX_DELETE 24
+
+static cstr statements[] = {
+    "i32 a = 1;\n", "const u32 x = 1 + 2 * 3;\n", "static i64 *const p;\n", "u8 arr[4 << 1] = 3 ? 4 : 5;\n",
+    "f64 f = .5;\n", "enum Color { RED, GREEN, BLUE }\n", "i32 y = x += 2;\n", "u8 s = \"hi\\n\";\n",
+};
+
+static cstr fragments[] = {
+    "", " ", "\n", ";", "i32", "b", "=", " = 2", "+ 3", "(", ")", "{", "}", ",", "enum E { A", "[", "]", "\"", "'c'",
+    "/", "*", "//", "/* c */", "0x1f", "1.5e3", "@", "static", "i32 z = 4;", "enum E { A }",
+};
+
+// What printStmtList writes for `list`, to be freed by the caller
+static char *printed(const SourceFile *source, StmtList list) {
+    fflush(stdout);
+    FILE *out = tmpfile();
+    int saved = dup(STDOUT_FILENO);
+    if (out == NULL || saved < 0) exit(1);
+    dup2(fileno(out), STDOUT_FILENO);
+    printStmtList(source, list);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    long size = ftell(out);
+    char *text = malloc(size + 1);
+    if (text == NULL) exit(1);
+    rewind(out);
+    text[fread(text, 1, size, out)] = '\0';
+    fclose(out);
+    return text;
+}
+
+static void checkDocument(Document *doc, u64 iteration) {
+    TokensList tokens = {0};
+    scanSource(&tokens, &doc->source);
+    TokensList kept = documentTokens(doc);
+    Bool same = kept.len == tokens.len;
+    for (usize i = 0; i < tokens.len && same; i++)
+        same = kept.arr[i].type == tokens.arr[i].type && kept.arr[i].offset == tokens.arr[i].offset;
+    testCheck(same, "tokens against scanSource", iteration);
+
+    Arena arena = {0};
+    Diagnostics diagnostics = {0};
+    StmtList list = parse(&arena, &doc->source, tokens, &diagnostics);
+    Diagnostics reported = documentDiagnostics(doc);
+    same = reported.len == diagnostics.len;
+    for (usize i = 0; i < diagnostics.len && same; i++) {
+        same = reported.arr[i].offset == diagnostics.arr[i].offset &&
+               strcmp(reported.arr[i].message, diagnostics.arr[i].message) == 0;
+    }
+    testCheck(same, "diagnostics against parse", iteration);
+
+    char *expected = printed(&doc->source, list);
+    char *actual = printed(&doc->source, documentStatements(doc));
+    testCheck(strcmp(expected, actual) == 0, "statements against parse", iteration);
+
+    free(expected);
+    free(actual);
+    freeDiagnostics(&diagnostics);
+    freeArena(&arena);
+    freeTokensList(&tokens);
+}
+
+int main(void) {
+    u64 seed = 20;
+    char path[] = "/tmp/documentXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) exit(1);
+    for (usize i = 0; i < DOCUMENT_TEST_STATEMENTS; i++) {
+        cstr statement = statements[testRandom(&seed) % (sizeof(statements) / sizeof(statements[0]))];
+        if (write(fd, statement, strlen(statement)) < 0) exit(1);
+    }
+    close(fd);
+
+    Document doc;
+    ErrCode err = openDocument(&doc, path);
+    unlink(path);
+    if (err != NO_ERR) {
+        fprintf(stderr, "Failed to open the document\n");
+        return 1;
+    }
+    checkDocument(&doc, 0);
+
+    for (u64 i = 1; i <= DOCUMENT_TEST_EDITS && testFailures == 0; i++) {
+        u32 len = (u32)doc.source.contents.len;
+        u32 start = (u32)(testRandom(&seed) % (len + 1));
+        if (i % 4 == 0 && len > 8) start = len - (u32)(testRandom(&seed) % 8);
+        u32 end = start + (u32)(testRandom(&seed) % (DOCUMENT_TEST_MAX_DELETE + 1));
+        if (end > len) end = len;
+
+        // Mostly fragments, sometimes a whole statement, and every so often the text would run dry without them
+        cstr insert;
+        if (testRandom(&seed) % 4 == 0 || len < 64)
+            insert = statements[testRandom(&seed) % (sizeof(statements) / sizeof(statements[0]))];
+        else
+            insert = fragments[testRandom(&seed) % (sizeof(fragments) / sizeof(fragments[0]))];
+        String text = {.data = (u8 *)insert, .len = strlen(insert)};
+        // NUL bytes lex as EOF tokens and stop the parser, with the tokens after them still there
+        if (testRandom(&seed) % 200 == 0) text = (String){.data = (u8 *)"", .len = 1};
+        if (editDocument(&doc, start, end, text) != NO_ERR) {
+            testCheck(FALSE, "editing", i);
+            break;
+        }
+        checkDocument(&doc, i);
+    }
+
+    closeDocument(&doc);
+    freeInterner();
+    return testFailures == 0 ? 0 : 1;
+}
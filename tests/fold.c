@@ -0,0 +1,132 @@
+#include "Bytecode.h"
+#include "Fold.h"
+#include "Interner.h"
+#include "Test.h"
+
+#include <limits.h>
+#include <math.h>
+
+/**
+ * Diagnostics and results of constant folding, see Fold.h. Every case is a single declaration: the error folding
+ * reports for it, if any, and the constant its initializer ends up as, if it is folded at all. Operands that are never
+ * evaluated must not report anything. Folded reals are then evaluated as int through evalExpr and the bytecode, which
+ * saturate them.
+ */
+
+typedef struct {
+    cstr source;
+    cstr error; // NULL if the declaration folds cleanly
+    Bool folded;
+    Constant value; // The initializer, if it is folded
+} FoldCase;
+
+#define INTEGER(t, v) {.type = t, .as.integer = (u64)(v)}
+#define REAL(t, v)    {.type = t, .as.real = v}
+
+#define OVERFLOW         "Integer overflow in constant expression"
+#define DIVISION_BY_ZERO "Division by zero in constant expression"
+#define SHIFT_COUNT      "Shift count out of range"
+#define DOES_NOT_FIT     "Constant does not fit in the declared type"
+
+static const FoldCase cases[] = {
+    {"i32 a = 1 + 2 * 3;", NULL, TRUE, INTEGER(TOK_I32, 7)},
+    // Signed overflow leaves the operator as it is
+    {"i32 a = 2147483647 + 1;", OVERFLOW, FALSE, {0}},
+    {"i32 a = 65536 * 65536;", OVERFLOW, FALSE, {0}},
+    {"i32 a = -(-2147483647 - 1);", OVERFLOW, FALSE, {0}},
+    {"u32 a = 0 - 1;", NULL, TRUE, INTEGER(TOK_U32, 4294967295u)},
+    {"i32 a = 1 / 0;", DIVISION_BY_ZERO, FALSE, {0}},
+    {"i32 a = 7 % 0;", DIVISION_BY_ZERO, FALSE, {0}},
+    {"f64 a = 1.0 / 0;", NULL, TRUE, REAL(TOK_F64, INFINITY)},
+    {"i32 a = 1 << 32;", SHIFT_COUNT, FALSE, {0}},
+    {"i32 a = 1 << -1;", SHIFT_COUNT, FALSE, {0}},
+    {"i32 a = 1 << 31;", OVERFLOW, FALSE, {0}},
+    {"i32 a = -8 >> 1;", NULL, TRUE, INTEGER(TOK_I32, -4)},
+    // Initializers that don't fit are reported and converted all the same
+    {"u8 a = 255 + 1;", DOES_NOT_FIT, TRUE, INTEGER(TOK_U8, 0)},
+    {"i8 a = 200;", DOES_NOT_FIT, TRUE, INTEGER(TOK_I8, -56)},
+    {"i32 a = 1e10;", DOES_NOT_FIT, TRUE, INTEGER(TOK_I32, 0)},
+    {"f32 a = 1e300;", DOES_NOT_FIT, TRUE, REAL(TOK_F32, INFINITY)},
+    {"u8 a = 0 - 128;", NULL, TRUE, INTEGER(TOK_U8, 128)},
+    // Operands that are never evaluated can't fail
+    {"i32 a = 0 && 1 / 0;", NULL, TRUE, INTEGER(TOK_I32, 0)},
+    {"i32 a = 1 || 1 << 40;", NULL, TRUE, INTEGER(TOK_I32, 1)},
+    {"i32 a = 1 ? 2 : 2147483647 + 1;", NULL, FALSE, {0}},
+    {"i32 a = 0 ? 7 % 0 : 2;", NULL, FALSE, {0}},
+    {"i32 a = 1 && 1 / 0;", DIVISION_BY_ZERO, FALSE, {0}},
+    {"i32 a = 0 ? 1 : 1 << 32;", SHIFT_COUNT, FALSE, {0}},
+};
+
+// Folded reals evaluated as int
+static const struct {
+    cstr source;
+    int value;
+} saturated[] = {
+    {"f64 a = 1e300;", INT_MAX},
+    {"f64 a = -1e300;", INT_MIN},
+    {"f64 a = 0.0 / 0.0;", 0},
+    {"f64 a = -2.75;", -2},
+};
+
+static Bool sameConstant(Constant lhs, Constant rhs) {
+    if (lhs.type != rhs.type) return FALSE;
+    if (lhs.type == TOK_F32 || lhs.type == TOK_F64) return lhs.as.real == rhs.as.real;
+    return lhs.as.integer == rhs.as.integer;
+}
+
+// Folds the one declaration in `text`, NULL if it doesn't parse
+static Expr *foldDeclaration(Arena *arena, cstr text, Diagnostics *diagnostics) {
+    SourceFile source;
+    StmtList list = testParse(arena, &source, text, diagnostics);
+    free(source.lineStarts);
+    if (list.len != 1 || diagnostics->len != 0) {
+        fprintf(stderr, "%s: doesn't parse\n", text);
+        testFailures++;
+        return NULL;
+    }
+    foldStmtList(list, diagnostics);
+    return list.arr[0]->as.declaration.initializer;
+}
+
+static void checkCase(const FoldCase *c, u64 iteration) {
+    Arena arena = {0};
+    Diagnostics diagnostics = {0};
+    Expr *initializer = foldDeclaration(&arena, c->source, &diagnostics);
+    if (initializer != NULL) {
+        Bool reported = c->error == NULL ? diagnostics.len == 0
+                                         : diagnostics.len == 1 && strcmp(diagnostics.arr[0].message, c->error) == 0;
+        if (!reported) fprintf(stderr, "%s: ", c->source);
+        testCheck(reported, "reporting", iteration);
+
+        Bool folded = initializer->type == EXPR_CONSTANT;
+        Bool same = folded == c->folded && (!folded || sameConstant(initializer->as.constant.value, c->value));
+        if (!same) fprintf(stderr, "%s: ", c->source);
+        testCheck(same, "folding", iteration);
+    }
+    freeDiagnostics(&diagnostics);
+    freeArena(&arena);
+}
+
+int main(void) {
+    for (usize i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) checkCase(&cases[i], i);
+
+    for (usize i = 0; i < sizeof(saturated) / sizeof(saturated[0]); i++) {
+        Arena arena = {0};
+        Diagnostics diagnostics = {0};
+        Expr *initializer = foldDeclaration(&arena, saturated[i].source, &diagnostics);
+        if (initializer != NULL) {
+            Bytecode code;
+            Bool compiled = compileExpr(&code, initializer);
+            Bool same = compiled && evalExpr(initializer) == saturated[i].value &&
+                        runBytecode(&code, NULL) == saturated[i].value;
+            if (!same) fprintf(stderr, "%s: ", saturated[i].source);
+            testCheck(same, "saturating", i);
+            if (compiled) freeBytecode(&code);
+        }
+        freeDiagnostics(&diagnostics);
+        freeArena(&arena);
+    }
+
+    freeInterner();
+    return testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#include "Interner.h"
+#include "Jit.h"
+#include "Test.h"
+
+/**
+ * Differential test of the JIT: jitRun against runBytecode and evalExpr on random expressions, see Test.h.
+ * Trees of literals are checked against all three evaluators, trees reading identifiers against runBytecode under a
+ * few different environments, since evalExpr can't read identifiers.
+ */
+
+#define JIT_EXPRESSIONS 20000
+#define JIT_MAX_DEPTH 6
+#define JIT_VARIABLES 4
+#define JIT_ENVIRONMENTS 4
+
+int main(void) {
+    static u8 letters[] = "abcd";
+    Symbol names[JIT_VARIABLES];
+    for (usize i = 0; i < JIT_VARIABLES; i++) names[i] = intern((String){.data = letters + i, .len = 1});
+
+    u64 seed = 23;
+    for (u64 i = 0; i < JIT_EXPRESSIONS; i++) {
+        Arena arena = {0};
+        Bool useVariables = i % 2 == 1;
+        RandomExpr random = {.arena = &arena, .seed = &seed, .names = names};
+        random.nameCount = useVariables ? JIT_VARIABLES : 0;
+        Expr *root = randomExpr(&random, 1 + i % JIT_MAX_DEPTH);
+
+        JitExpr jit;
+        Bytecode code;
+        if (!jitCompileExpr(&jit, root) || !compileExpr(&code, root)) {
+            testCheck(FALSE, "compiling", i);
+            freeArena(&arena);
+            continue;
+        }
+#if defined(__x86_64__) && defined(__linux__)
+        // Otherwise jitRun only runs the bytecode
+        testCheck(jit.function != NULL, "generating native code", i);
+#endif
+        if (!useVariables) {
+            int expected = evalExpr(root);
+            testCheck(runBytecode(&code, NULL) == expected, "runBytecode against evalExpr", i);
+            testCheck(jitRun(&jit, NULL) == expected, "jitRun against evalExpr", i);
+        }
+        for (usize e = 0; e < JIT_ENVIRONMENTS; e++) {
+            int env[JIT_VARIABLES];
+            for (usize v = 0; v < code.variables.len; v++) env[v] = (int)((u32)testRandom(&seed) >> (e * 8));
+            testCheck(jitRun(&jit, env) == runBytecode(&code, env), "jitRun against runBytecode", i);
+        }
+
+        freeBytecode(&code);
+        freeJitExpr(&jit);
+        freeArena(&arena);
+    }
+
+    freeInterner();
+    return testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+#include "Interner.h"
+#include "Resolve.h"
+#include "Test.h"
+
+/**
+ * Name resolution, see Resolve.h: the errors resolveStmtList reports for redeclarations and undeclared names, enum
+ * constants rewritten to constants, identifiers bound to their declaration and scopes putting back what they shadowed.
+ */
+
+#define REDEFINITION "Redefinition of a name declared in the same scope"
+#define UNDECLARED   "Use of an undeclared identifier"
+
+typedef struct {
+    cstr message;
+    u32 offset;
+} Expected;
+
+static const struct {
+    cstr source;
+    Expected errors[2]; // Up to the first with a NULL message
+} cases[] = {
+    // A file scope variable may be declared again while only one of the declarations has an initializer
+    {"i32 a; i32 a = 1; i32 a;", {{0}}},
+    {"i32 a = 1; i32 a = 2;", {{REDEFINITION, 15}}},
+    {"i32 a = 1; i32 b; i32 a = 1;", {{REDEFINITION, 22}}},
+    {"i32 a = b;", {{UNDECLARED, 8}}},
+    {"i32 a = 1 + (b * c);", {{UNDECLARED, 13}, {UNDECLARED, 17}}},
+    {"i32 x[N];", {{UNDECLARED, 6}}},
+    // In scope from its own initializer on
+    {"i32 a = a;", {{0}}},
+    {"i32 a = 1; i32 b = a;", {{0}}},
+    // Enum constants share the namespace of variables, enum names have their own
+    {"enum E { A }; i32 A;", {{REDEFINITION, 18}}},
+    {"i32 A; enum E { A }", {{REDEFINITION, 16}}},
+    {"enum E { A, A }", {{REDEFINITION, 12}}},
+    {"enum E { A } enum E { B }", {{"Redefinition of an enum", 18}}},
+    {"enum E { A }; i32 E = 1;", {{0}}},
+};
+
+// Parses and resolves `text` at file scope of `table`, NULL if it doesn't parse
+static StmtList resolveText(Arena *arena, SymbolTable *table, cstr text, Diagnostics *diagnostics) {
+    SourceFile source;
+    StmtList list = testParse(arena, &source, text, diagnostics);
+    free(source.lineStarts);
+    if (diagnostics->len != 0) {
+        fprintf(stderr, "%s: doesn't parse\n", text);
+        testFailures++;
+        return (StmtList){0};
+    }
+    resolveStmtList(table, list, diagnostics);
+    return list;
+}
+
+static void checkErrors(u64 iteration) {
+    Arena arena = {0};
+    SymbolTable table = {0};
+    Diagnostics diagnostics = {0};
+    cstr source = cases[iteration].source;
+    resolveText(&arena, &table, source, &diagnostics);
+
+    const Expected *errors = cases[iteration].errors;
+    usize count = 0;
+    while (count < 2 && errors[count].message != NULL) count++;
+    Bool same = diagnostics.len == count;
+    for (usize i = 0; i < count && same; i++) {
+        const Diagnostic *diagnostic = &diagnostics.arr[i];
+        same = strcmp(diagnostic->message, errors[i].message) == 0 && diagnostic->offset == errors[i].offset;
+    }
+    if (!same) fprintf(stderr, "%s: ", source);
+    testCheck(same, "reporting", iteration);
+
+    freeDiagnostics(&diagnostics);
+    freeSymbolTable(&table);
+    freeArena(&arena);
+}
+
+static Bool isConstant(const Expr *expr, u64 value) {
+    return expr->type == EXPR_CONSTANT && expr->as.constant.value.type == TOK_I32 &&
+           expr->as.constant.value.as.integer == value;
+}
+
+static void checkBindings(void) {
+    Arena arena = {0};
+    SymbolTable table = {0};
+    Diagnostics diagnostics = {0};
+    cstr source = "enum E { A, B, C }; i32 a = C; i32 x[B + 1]; i32 b = a;";
+    StmtList list = resolveText(&arena, &table, source, &diagnostics);
+    testCheck(list.len == 4 && diagnostics.len == 0, "resolving", 0);
+    if (list.len != 4) {
+        freeDiagnostics(&diagnostics);
+        freeSymbolTable(&table);
+        freeArena(&arena);
+        return;
+    }
+
+    // Enum constants become i32 constants, which evaluate without a table
+    testCheck(isConstant(list.arr[1]->as.declaration.initializer, 2), "rewriting an initializer", 0);
+    Expr *size = list.arr[2]->as.declaration.type->as.array.size;
+    testCheck(size->type == EXPR_BINARY && isConstant(size->as.binary.lhs, 1), "rewriting an array size", 0);
+    testCheck(evalExpr(size) == 2, "evaluating a rewritten array size", 0);
+
+    // Variables stay identifiers, bound to their declaration
+    const Expr *a = list.arr[3]->as.declaration.initializer;
+    Bool bound = a->type == EXPR_LITERAL && a->as.primary.declaration < table.declarations.len &&
+                 table.declarations.arr[a->as.primary.declaration].stmt == list.arr[1];
+    testCheck(bound, "binding a variable", 0);
+
+    // An inner scope shadows `a` and the enum constant `A`, leaving it brings back both
+    Symbol aName = list.arr[1]->as.declaration.identifier.as.identifier.symbol;
+    u32 outer = lookupSymbol(&table, aName);
+    pushScope(&table);
+    StmtList inner = resolveText(&arena, &table, "i32 a = A; i32 A = a;", &diagnostics);
+    testCheck(inner.len == 2 && diagnostics.len == 0, "shadowing", 0);
+    if (inner.len == 2) {
+        testCheck(isConstant(inner.arr[0]->as.declaration.initializer, 0), "reading an outer enum constant", 0);
+        testCheck(lookupSymbol(&table, aName) != outer, "binding in the inner scope", 0);
+    }
+    popScope(&table);
+    testCheck(lookupSymbol(&table, aName) == outer, "leaving the scope", 0);
+
+    freeDiagnostics(&diagnostics);
+    freeSymbolTable(&table);
+    freeArena(&arena);
+}
+
+int main(void) {
+    for (usize i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) checkErrors(i);
+    checkBindings();
+
+    freeInterner();
+    return testFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+#include "Expression.h"
+#include "FlatAst.h"
+#include "Statement.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+/**
+ * Deep nesting stress test for the passes built on walk, see Walk.h.
+ * Everything runs on a thread with a small stack, so a pass that recursed once per level of nesting would crash here
+ * long before it reached the depths generated code produces. Evaluation, cloning, flattening and freeing get a million
+ * deep `1 + 1 + ...` chain and a million deep `((((1))))`. Printing writes an indentation proportional to the depth on
+ * every line, it gets shallower trees that still nest far deeper than the stack could hold frames for.
+ * Trees are printed to stdout, failures are reported on stderr.
+ */
+
+#define STRESS_DEPTH 1000000
+#define STRESS_PRINT_DEPTH 2000
+#define STRESS_STACK_SIZE (64 * 1024)
+
+static u8 text[] = "1 x\n";
+static SourceFile source = {.contents = {.data = text, .len = sizeof(text) - 1}};
+static const Token one = {.type = TOK_INTEGER_LITERAL, .offset = 0, .as.integerLiteral = 1};
+static const Token name = {.type = TOK_IDENTIFIER, .offset = 2, .as.identifier.span = {.offset = 2, .len = 1}};
+static const Token i32Keyword = {.type = TOK_I32, .offset = 0};
+
+static usize failures = 0;
+
+static void check(Bool ok, cstr tree, cstr what) {
+    if (ok) return;
+    fprintf(stderr, "%s: %s failed\n", tree, what);
+    failures++;
+}
+
+// 1 + 1 + ... + 1 with `depth` operators, left associative the way the parser builds it
+static Expr *makeChain(Arena *arena, usize depth) {
+    Expr *root = makePrimaryExpr(arena, one);
+    for (usize i = 0; i < depth; i++) root = makeBinaryExpr(arena, TOK_PLUS, root, makePrimaryExpr(arena, one));
+    return root;
+}
+
+// `depth` pairs of parentheses around a 1
+static Expr *makeNested(Arena *arena, usize depth) {
+    Expr *root = makePrimaryExpr(arena, one);
+    for (usize i = 0; i < depth; i++) root = makeGroupingExpr(arena, root);
+    return root;
+}
+
+static void stressExpr(cstr tree, Expr *root, int expected) {
+    check(evalExpr(root) == expected, tree, "evalExpr");
+
+    Arena clones = {0};
+    Expr *clone = cloneExpr(&clones, root);
+    check(evalExpr(clone) == expected, tree, "evalExpr of the clone");
+
+    FlatAst flat = {0};
+    FlatRef ref = flattenExpr(&flat, clone);
+    check(evalFlatExpr(&flat, ref) == expected, tree, "evalFlatExpr");
+    freeFlatAst(&flat);
+    freeArena(&clones);
+}
+
+static void stressPrint(Expr *root) {
+    printExpr(&source, root);
+
+    FlatAst flat = {0};
+    printFlatExpr(&source, &flat, flattenExpr(&flat, root));
+    freeFlatAst(&flat);
+}
+
+static void *runStress(void *arg) {
+    (void)arg;
+    Arena arena = {0};
+    stressExpr("1 + 1 + ...", makeChain(&arena, STRESS_DEPTH), STRESS_DEPTH + 1);
+    stressExpr("((((1))))", makeNested(&arena, STRESS_DEPTH), 1);
+    freeArena(&arena);
+
+    stressPrint(makeChain(&arena, STRESS_PRINT_DEPTH));
+    stressPrint(makeNested(&arena, STRESS_PRINT_DEPTH));
+
+    // i32 ****...* x = 1
+    Type *type = makePrimitiveType(&arena, i32Keyword, FALSE);
+    for (usize i = 0; i < STRESS_PRINT_DEPTH; i++) type = makePointerType(&arena, type, FALSE);
+    StmtList list = {0};
+    appendSingle(&list, makeVarStmt(&arena, type, STORAGE_NONE, name, makePrimaryExpr(&arena, one)));
+    printStmtList(&source, list);
+    free(list.arr);
+    freeArena(&arena);
+    return NULL;
+}
+
+int main(void) {
+    buildLineIndex(&source);
+
+    pthread_attr_t attributes;
+    pthread_t thread;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, STRESS_STACK_SIZE);
+    if (pthread_create(&thread, &attributes, runStress, NULL) != 0) {
+        fprintf(stderr, "Could not start the stress thread\n");
+        return 1;
+    }
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attributes);
+
+    free(source.lineStarts);
+    return failures == 0 ? 0 : 1;
+}